@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "audio_transcode_worker.h"
+
+// 清单文件每行一个任务："输入文件 输出文件"，空行和 # 开头的行被忽略
+static void usage(const char *program_name) {
+    std::cout << "usage: " << std::string(program_name)
+              << " manifest decoder encoder [workers] [sample_rate] [ch_layout] [bit_rate]" << std::endl;
+}
+
+static int32_t load_manifest(const char *manifest, std::vector<AudioTranscodeJob> &jobs) {
+    std::ifstream file(manifest);
+    if (!file) {
+        std::cerr << "Error: cannot open manifest " << std::string(manifest) << std::endl;
+        return -1;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') { continue; }
+        size_t split = line.find_first_of(" \t");
+        size_t output = split == std::string::npos ? split : line.find_first_not_of(" \t", split);
+        if (output == std::string::npos) {
+            std::cerr << "Error: invalid manifest line: " << line << std::endl;
+            return -1;
+        }
+        AudioTranscodeJob job;
+        job.input_file = line.substr(0, split);
+        job.output_file = line.substr(output);
+        job.result = 0;
+        job.latency_us = 0;
+        jobs.push_back(job);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    AudioTranscodeConfig config;
+    config.decoder_name = argv[2];
+    config.encoder_name = argv[3];
+    int32_t nb_workers = argc > 4 ? atoi(argv[4]) : 0;
+    config.sample_rate = argc > 5 ? atoi(argv[5]) : 44100;
+    config.ch_layout = argc > 6 ? argv[6] : "stereo";
+    config.bit_rate = argc > 7 ? atoll(argv[7]) : 128000;
+
+    std::vector<AudioTranscodeJob> jobs;
+    if (load_manifest(argv[1], jobs) < 0) { return -1; }
+
+    auto start = std::chrono::steady_clock::now();
+    int32_t failed = run_audio_transcode_batch(config, jobs, nb_workers);
+    int64_t wall_time_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    print_audio_transcode_stats(jobs, wall_time_us);
+    if (failed > 0) {
+        std::cerr << "Error: " << failed << " of " << jobs.size() << " files failed." << std::endl;
+        return -1;
+    }
+    return 0;
+}
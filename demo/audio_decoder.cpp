@@ -7,11 +7,12 @@
 
 static void usage(const char *program_name) {
     std::cout << "usage: " << std::string(program_name)
-            << " input_file output_file audio_format(MP3/AAC)" << std::endl;
+            << " input_file output_file codec(mp3/aac/flac/ac3/opus/vorbis...)"
+            << " [ch_layout(mono/stereo) sample_rate sample_fmt(s16/flt/fltp)]" << std::endl;
 }
 
 int main(int argc, char *argv[]) {
-    if (argc < 3) {
+    if (argc < 4) {
         usage(argv[0]);
         return 1;
     }
@@ -27,7 +28,11 @@ int main(int argc, char *argv[]) {
         return res;
     }
 
-    res = init_audio_decoder(argv[3]);
+    // 例如 "mono 16000 s16" 直接得到语音识别需要的格式
+    const char *ch_layout = argc > 4 ? argv[4] : nullptr;
+    int32_t sample_rate = argc > 5 ? atoi(argv[5]) : 0;
+    const char *sample_fmt = argc > 6 ? argv[6] : nullptr;
+    res = init_audio_decoder(argv[3], ch_layout, sample_rate, sample_fmt);
     if (res != 0) {
         return res;
     }
@@ -7,7 +7,7 @@
 
 static void usage(const char *program_name) {
     std::cout << "usage: " << std::string(program_name)
-              << " input_yuv output_file codec_name" << std::endl;
+              << " input_pcm output_file codec_name [sample_fmt(s16/s32/flt) sample_rate ch_layout]" << std::endl;
 }
 
 int main(int argc, char *argv[]) {
@@ -29,7 +29,8 @@ int main(int argc, char *argv[]) {
         goto out;
     }
 
-    result = init_audio_encoder(argv[3]);
+    result = init_audio_encoder(
+        argv[3], argc > 4 ? argv[4] : "flt", argc > 5 ? atoi(argv[5]) : 44100, argc > 6 ? argv[6] : "stereo");
     if (result < 0) {
         goto out;;
     }
@@ -6,7 +6,8 @@
 #include "io_data.h"
 
 static void usage(const char *program_name) {
-    std::cout << "usage: " << std::string(program_name) << " input_file output_file " << std::endl;
+    std::cout << "usage: " << std::string(program_name)
+              << " input_file output_file filter_descr [frame_size] [volume@seconds,...]" << std::endl;
 }
 
 int main(int argc, char **argv) {
@@ -17,18 +18,39 @@ int main(int argc, char **argv) {
 
     char *input_file_name = argv[1];
     char *output_file_name = argv[2];
-    char *volume_factor = argv[3];
+    char *filter_descr = argv[3];
+    int32_t frame_size = argc > 4 ? atoi(argv[4]) : 4096;
 
     int32_t result = 0;
     do {
         result = open_input_output_files(input_file_name, output_file_name);
         if (result < 0) { break; }
-        result = init_audio_filter(volume_factor);
+        result = init_audio_filter(filter_descr, frame_size);
         if (result < 0) { break; }
+        // 例如 "0.5@10,2.0@30"：第 10 秒起音量改为 0.5，第 30 秒起改为 2.0
+        if (argc > 5) {
+            std::string schedule(argv[5]);
+            size_t start = 0;
+            while (result >= 0 && start < schedule.size()) {
+                size_t end = schedule.find(',', start);
+                if (end == std::string::npos) { end = schedule.size(); }
+                std::string item = schedule.substr(start, end - start);
+                size_t at = item.find('@');
+                if (at == std::string::npos) {
+                    std::cerr << "Error: invalid volume schedule item: " << item << std::endl;
+                    result = -1;
+                    break;
+                }
+                result = set_audio_volume(item.substr(0, at).c_str(), atof(item.substr(at + 1).c_str()));
+                start = end + 1;
+            }
+            if (result < 0) { break; }
+        }
         result = audio_filtering();
         if (result < 0) { break; }
     } while (0);
 
+    print_audio_filter_stats();
     destroy_audio_filter();
     close_input_output_files();
     return result;
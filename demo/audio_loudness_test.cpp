@@ -0,0 +1,86 @@
+#include <sys/stat.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "audio_loudness.h"
+
+// 检查响度归一化的单位与缓存：安静的正弦波应得到正增益且峰值以 dBFS 报告，
+// 峰值限制按 dB 计算，旧版本（线性峰值）的缓存文件被忽略。失败时返回非 0。
+// 输入格式与 audio_loudnorm 相同：44100Hz 立体声 float 交错 PCM
+#define SAMPLE_RATE   44100
+#define DURATION      10
+#define AMPLITUDE     0.02 // -34 dBFS
+#define INPUT_FILE    "audio_loudness_test.pcm"
+#define TARGET_LUFS   -23.0
+#define PEAK_LIMIT_DB -1.0
+
+static int32_t write_test_input() {
+    FILE *file = fopen(INPUT_FILE, "wb");
+    if (!file) { return -1; }
+    std::vector<float> samples(SAMPLE_RATE * 2);
+    for (int32_t second = 0; second < DURATION; second++) {
+        for (int32_t i = 0; i < SAMPLE_RATE; i++) {
+            float value = (float)(AMPLITUDE * sin(2.0 * M_PI * 1000.0 * i / SAMPLE_RATE));
+            samples[i * 2] = samples[i * 2 + 1] = value;
+        }
+        fwrite(samples.data(), sizeof(float), samples.size(), file);
+    }
+    fclose(file);
+    return 0;
+}
+
+static bool check(bool ok, const char *name) {
+    std::cout << (ok ? "PASS " : "FAIL ") << name << std::endl;
+    return ok;
+}
+
+int main() {
+    if (write_test_input() < 0) {
+        std::cerr << "Error: failed to write test input." << std::endl;
+        return 1;
+    }
+    std::string cache_file = std::string(INPUT_FILE) + ".loudness";
+    int32_t failed = 0;
+
+    LoudnessStats stats;
+    if (analyze_loudness(INPUT_FILE, stats) < 0) {
+        std::cerr << "FAIL analyze_loudness" << std::endl;
+        remove(INPUT_FILE);
+        return 1;
+    }
+    double expected_peak = 20.0 * log10(AMPLITUDE);
+    failed += !check(fabs(stats.peak - expected_peak) < 0.5, "sample peak reported in dBFS");
+
+    double gain = compute_loudness_gain(stats, TARGET_LUFS, PEAK_LIMIT_DB);
+    std::cout << "I=" << stats.integrated << " LUFS, peak=" << stats.peak << " dBFS, gain=" << gain << " dB"
+              << std::endl;
+    failed += !check(gain > 5.0 && fabs(gain - (TARGET_LUFS - stats.integrated)) < 1e-9, "quiet input gets boost");
+
+    // 峰值 -3 dBFS 时最多提升 2 dB
+    LoudnessStats loud = {-30.0, 5.0, -3.0};
+    failed += !check(fabs(compute_loudness_gain(loud, TARGET_LUFS, PEAK_LIMIT_DB) - 2.0) < 1e-9, "peak limit in dB");
+
+    // 版本 1 的缓存没有 version 字段，峰值是线性值；文件签名与输入一致，只有版本不同
+    struct stat info;
+    stat(INPUT_FILE, &info);
+    {
+        std::ofstream old_cache(cache_file, std::ios::trunc);
+        old_cache << "size " << (int64_t)info.st_size << "\nmtime " << (int64_t)info.st_mtime
+                  << "\nintegrated -34\nrange 0\npeak 0.02\n";
+    }
+    LoudnessStats cached;
+    failed += !check(load_loudness_cache(INPUT_FILE, cached) < 0, "old cache version ignored");
+
+    bool round_trip = save_loudness_cache(INPUT_FILE, stats) >= 0 && load_loudness_cache(INPUT_FILE, cached) >= 0
+                      && cached.integrated == stats.integrated && cached.peak == stats.peak;
+    failed += !check(round_trip, "cache round trip");
+
+    remove(cache_file.c_str());
+    remove(INPUT_FILE);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,29 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "audio_loudness.h"
+
+// 输入输出与 audio_filter 相同：44100Hz 立体声 float 交错 PCM。
+// 第一次运行分析并写入 "<input_file>.loudness"，之后换目标响度再运行会直接使用缓存。
+// target_lufs 例如 -23 (EBU R128) 或 -16 (流媒体)；peak_limit 默认 -1 dBFS；nocache 强制重新分析
+static void usage(const char *program_name) {
+    std::cout << "usage: " << std::string(program_name) << " input_file output_file target_lufs [peak_limit] [nocache]"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    char *input_file_name = argv[1];
+    char *output_file_name = argv[2];
+    double target_lufs = atof(argv[3]);
+    double peak_limit = argc > 4 ? atof(argv[4]) : -1.0;
+    bool use_cache = !(argc > 5 && !strcmp(argv[5], "nocache"));
+
+    return normalize_loudness(input_file_name, output_file_name, target_lufs, peak_limit, use_cache);
+}
@@ -0,0 +1,172 @@
+extern "C" {
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavfilter/buffersrc.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+#include <libavutil/mem.h>
+#include <libavutil/samplefmt.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "audio_mixer.h"
+
+// 同样的 N 路 48kHz 立体声输入，AudioMixer 与 amix 滤镜（normalize=0，按相同权重）的吞吐量对比。
+// 参数：[nb_inputs=32] [seconds=600] [frame_size=1024]
+#define SAMPLE_RATE 48000
+
+// 每路输入一个预先填好伪随机样本的帧，送入时只改时间戳
+static int32_t alloc_input_frames(std::vector<AVFrame *> &frames, int32_t nb_inputs, int32_t frame_size) {
+    uint32_t seed = 1;
+    for (int32_t i = 0; i < nb_inputs; i++) {
+        AVFrame *frame = av_frame_alloc();
+        if (!frame) { return -1; }
+        frames.push_back(frame);
+        frame->nb_samples = frame_size;
+        frame->format = AV_SAMPLE_FMT_FLTP;
+        frame->sample_rate = SAMPLE_RATE;
+        frame->ch_layout = AV_CHANNEL_LAYOUT_STEREO;
+        if (av_frame_get_buffer(frame, 0) < 0) { return -1; }
+        for (int32_t ch = 0; ch < 2; ch++) {
+            float *samples = (float *)frame->extended_data[ch];
+            for (int32_t j = 0; j < frame_size; j++) {
+                seed = seed * 1103515245 + 12345;
+                samples[j] = ((seed >> 16) & 0x7fff) / 32768.0f - 0.5f;
+            }
+        }
+    }
+    return 0;
+}
+
+static int32_t run_mixer(const std::vector<AVFrame *> &frames, int32_t nb_blocks, int64_t &mixed) {
+    int32_t nb_inputs = (int32_t)frames.size();
+    int32_t frame_size = frames[0]->nb_samples;
+    AudioMixer mixer;
+    AVChannelLayout ch_layout = AV_CHANNEL_LAYOUT_STEREO;
+    int32_t result = mixer.init(nb_inputs, SAMPLE_RATE, ch_layout, frame_size, 2 * frame_size);
+    if (result < 0) { return result; }
+    for (int32_t i = 0; i < nb_inputs; i++) { mixer.set_gain(i, 1.0f / nb_inputs); }
+    mixer.set_clip_mode(AUDIO_MIX_CLIP_HARD);
+
+    AVFrame *output = av_frame_alloc();
+    for (int32_t block = 0; block < nb_blocks && result >= 0; block++) {
+        for (int32_t i = 0; i < nb_inputs && result >= 0; i++) {
+            frames[i]->pts = (int64_t)block * frame_size;
+            result = mixer.send_frame(i, frames[i]);
+        }
+        while (result >= 0 && (result = mixer.receive_frame(output)) >= 0) {
+            mixed += output->nb_samples;
+            av_frame_unref(output);
+        }
+        if (result == AVERROR(EAGAIN)) { result = 0; }
+    }
+    av_frame_free(&output);
+    return result;
+}
+
+static int32_t run_amix(const std::vector<AVFrame *> &frames, int32_t nb_blocks, int64_t &mixed) {
+    int32_t nb_inputs = (int32_t)frames.size();
+    int32_t frame_size = frames[0]->nb_samples;
+    std::vector<AVFilterContext *> src_ctxs(nb_inputs, nullptr);
+    AVFilterContext *sink_ctx = nullptr;
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    if (!graph) { return AVERROR(ENOMEM); }
+
+    // "[in0][in1]...amix=inputs=N:normalize=0:weights=w w ...[out]"，abuffer 与 abuffersink 在解析前创建
+    std::string descr, weights;
+    char args[256];
+    int32_t result = 0;
+    for (int32_t i = 0; i < nb_inputs && result >= 0; i++) {
+        std::string name = "in" + std::to_string(i);
+        snprintf(
+            args, sizeof(args), "time_base=1/%d:sample_rate=%d:sample_fmt=fltp:channel_layout=stereo", SAMPLE_RATE,
+            SAMPLE_RATE);
+        result = avfilter_graph_create_filter(
+            &src_ctxs[i], avfilter_get_by_name("abuffer"), name.c_str(), args, NULL, graph);
+        descr += "[" + name + "]";
+        weights += (i ? " " : "") + std::to_string(1.0 / nb_inputs);
+    }
+    if (result >= 0) {
+        result =
+            avfilter_graph_create_filter(&sink_ctx, avfilter_get_by_name("abuffersink"), "out", NULL, NULL, graph);
+    }
+    descr += "amix=inputs=" + std::to_string(nb_inputs) + ":normalize=0:weights=" + weights + "[out]";
+
+    AVFilterInOut *outputs = nullptr;
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    for (int32_t i = nb_inputs; result >= 0 && i-- > 0;) {
+        AVFilterInOut *output = avfilter_inout_alloc();
+        if (!output) {
+            result = AVERROR(ENOMEM);
+            break;
+        }
+        output->name = av_strdup(("in" + std::to_string(i)).c_str());
+        output->filter_ctx = src_ctxs[i];
+        output->pad_idx = 0;
+        output->next = outputs;
+        outputs = output;
+    }
+    if (result >= 0 && inputs) {
+        inputs->name = av_strdup("out");
+        inputs->filter_ctx = sink_ctx;
+        inputs->pad_idx = 0;
+        inputs->next = NULL;
+        result = avfilter_graph_parse_ptr(graph, descr.c_str(), &inputs, &outputs, NULL);
+    }
+    if (result >= 0) { result = avfilter_graph_config(graph, NULL); }
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+
+    AVFrame *output = av_frame_alloc();
+    for (int32_t block = 0; block < nb_blocks && result >= 0; block++) {
+        for (int32_t i = 0; i < nb_inputs && result >= 0; i++) {
+            frames[i]->pts = (int64_t)block * frame_size;
+            result = av_buffersrc_add_frame_flags(src_ctxs[i], frames[i], AV_BUFFERSRC_FLAG_KEEP_REF);
+        }
+        while (result >= 0 && (result = av_buffersink_get_frame(sink_ctx, output)) >= 0) {
+            mixed += output->nb_samples;
+            av_frame_unref(output);
+        }
+        if (result == AVERROR(EAGAIN)) { result = 0; }
+    }
+    av_frame_free(&output);
+    avfilter_graph_free(&graph);
+    if (result < 0) { std::cerr << "Error: amix benchmark failed." << std::endl; }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    int32_t nb_inputs = argc > 1 ? atoi(argv[1]) : 32;
+    int32_t seconds = argc > 2 ? atoi(argv[2]) : 600;
+    int32_t frame_size = argc > 3 ? atoi(argv[3]) : 1024;
+    int32_t nb_blocks = (int32_t)((int64_t)seconds * SAMPLE_RATE / frame_size);
+
+    std::vector<AVFrame *> frames;
+    int32_t result = alloc_input_frames(frames, nb_inputs, frame_size);
+    double mixer_seconds = 0, amix_seconds = 0;
+    int64_t mixer_samples = 0, amix_samples = 0;
+    if (result >= 0) {
+        auto start = std::chrono::steady_clock::now();
+        result = run_mixer(frames, nb_blocks, mixer_samples);
+        mixer_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    if (result >= 0) {
+        auto start = std::chrono::steady_clock::now();
+        result = run_amix(frames, nb_blocks, amix_samples);
+        amix_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    for (size_t i = 0; i < frames.size(); i++) { av_frame_free(&frames[i]); }
+    if (result < 0) { return -1; }
+
+    std::cout << nb_inputs << " inputs, " << seconds << "s, frame size " << frame_size << std::endl;
+    std::cout << "AudioMixer: " << mixer_samples / mixer_seconds / SAMPLE_RATE << "x realtime" << std::endl;
+    std::cout << "amix: " << amix_samples / amix_seconds / SAMPLE_RATE << "x realtime" << std::endl;
+    std::cout << "speedup: " << (mixer_samples / mixer_seconds) / (amix_samples / amix_seconds) << "x" << std::endl;
+    return 0;
+}
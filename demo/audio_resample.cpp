@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -7,14 +8,14 @@
 
 static void usage(const char *program_name) {
     std::cout << "usage: " << std::string(program_name)
-              << " in_file in_sample_rate in_sample_fmt out_file out_sample_fmt "
-                 "out_sample_fmt "
+              << " in_file in_sample_rate in_sample_fmt in_ch_layout out_file out_sample_rate out_sample_fmt "
+                 "out_ch_layout [swr|soxr] [low|medium|high] [chunk_size] [matrix|-] [threads]"
               << std::endl;
 }
 
 int main(int argc, char **argv) {
     int result = 0;
-    if (argc < 7) {
+    if (argc < 9) {
         usage(argv[0]);
         return -1;
     }
@@ -28,17 +29,25 @@ int main(int argc, char **argv) {
     int32_t out_sample_rate = atoi(argv[6]);
     char *out_sample_fmt = argv[7];
     char *out_sample_layout = argv[8];
+    const char *engine = argc > 9 ? argv[9] : "swr";
+    const char *quality = argc > 10 ? argv[10] : "medium";
+    int32_t chunk_size = argc > 11 ? atoi(argv[11]) : 1152;
+    // 例如 5.1 -> stereo："1 0 0.707 0 0.707 0|0 1 0.707 0 0 0.707"
+    const char *matrix = argc > 12 && strcmp(argv[12], "-") ? argv[12] : nullptr;
+    // 大于 1 时按块并行重采样，整个输入文件一次处理完
+    int32_t threads = argc > 13 ? atoi(argv[13]) : 1;
 
     do {
         result = open_input_output_files(input_file_name, output_file_name);
         if (result < 0) { break; }
         result = init_audio_resampler(
-            in_sample_rate, in_sample_fmt, in_sample_layout, out_sample_rate, out_sample_fmt, out_sample_layout);
+            in_sample_rate, in_sample_fmt, in_sample_layout, out_sample_rate, out_sample_fmt, out_sample_layout, engine,
+            quality, matrix);
         if (result < 0) {
             std::cerr << "Error: init_audio_resampler failed." << std::endl;
             break;
         }
-        result = audio_resample();
+        result = threads > 1 ? audio_resample_parallel(threads) : audio_resample(chunk_size);
         if (result < 0) {
             std::cerr << "Error: audio_resampling failed." << std::endl;
             break;
@@ -46,6 +55,7 @@ int main(int argc, char **argv) {
     } while (0);
 
     close_input_output_files();
+    print_audio_resampler_stats();
     destroy_audio_resampler();
     return result;
 }
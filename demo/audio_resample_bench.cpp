@@ -0,0 +1,174 @@
+extern "C" {
+#include <libavutil/samplefmt.h>
+}
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "audio_resampler_core.h"
+
+// 重采样参数矩阵：采样率对 x 样本格式 x 声道布局 x 引擎/质量档位。
+// 输入为若干正弦波之和，理想输出就是同样的正弦波在输出时刻的取值，可以解析地算出，
+// 不依赖另一个重采样器作参考。降采样时额外加一个高于输出奈奎斯特频率的分量，理想输出中没有它，
+// 因此 SNR 同时包含通带误差、混叠与量化噪声（即 THD+N）。
+// 单线程运行，速度即每核的吞吐量。参数：[seconds=10]
+
+#define CHUNK_SAMPLES 4096
+
+struct RatePair {
+    int32_t in_rate;
+    int32_t out_rate;
+};
+
+struct EngineCase {
+    const char *engine;
+    const char *quality;
+};
+
+static const RatePair rate_pairs[] = {{44100, 48000}, {48000, 44100}, {48000, 16000}, {96000, 48000}};
+static const char *sample_fmts[] = {"s16", "flt", "dbl"};
+static const char *ch_layouts[] = {"mono", "stereo", "5.1"};
+static const EngineCase engine_cases[] = {
+    {"swr", "low"}, {"swr", "medium"}, {"swr", "high"}, {"soxr", "low"}, {"soxr", "medium"}, {"soxr", "high"},
+};
+
+struct Tone {
+    double frequency;
+    double amplitude;
+    bool in_output; // 是否在输出的频带内
+};
+
+static std::vector<Tone> test_tones(const RatePair &pair) {
+    int32_t min_rate = pair.in_rate < pair.out_rate ? pair.in_rate : pair.out_rate;
+    std::vector<Tone> tones;
+    tones.push_back({997.0, 0.3, true});
+    tones.push_back({0.4 * min_rate, 0.3, true});
+    // 落在输出阻带内，理想重采样器应将其完全滤除
+    if (pair.out_rate < pair.in_rate) { tones.push_back({0.3 * pair.out_rate + 0.2 * pair.in_rate, 0.2, false}); }
+    return tones;
+}
+
+// 每个声道相位不同，避免声道混合的错误被相同的信号掩盖
+static double tone_value(const std::vector<Tone> &tones, double t, int32_t ch, bool output_only) {
+    double value = 0;
+    for (size_t i = 0; i < tones.size(); i++) {
+        if (output_only && !tones[i].in_output) { continue; }
+        value += tones[i].amplitude * sin(2 * M_PI * tones[i].frequency * t + 0.7 * ch);
+    }
+    return value;
+}
+
+static void store_sample(uint8_t *dst, enum AVSampleFormat fmt, double value) {
+    if (fmt == AV_SAMPLE_FMT_S16) {
+        double scaled = floor(value * 32767.0 + 0.5);
+        ((int16_t *)dst)[0] = (int16_t)(scaled > 32767 ? 32767 : (scaled < -32768 ? -32768 : scaled));
+    } else if (fmt == AV_SAMPLE_FMT_FLT) {
+        ((float *)dst)[0] = (float)value;
+    } else {
+        ((double *)dst)[0] = value;
+    }
+}
+
+static double load_sample(const uint8_t *src, enum AVSampleFormat fmt) {
+    if (fmt == AV_SAMPLE_FMT_S16) { return ((const int16_t *)src)[0] / 32767.0; }
+    if (fmt == AV_SAMPLE_FMT_FLT) { return ((const float *)src)[0]; }
+    return ((const double *)src)[0];
+}
+
+static int32_t layout_channels(const char *layout) {
+    if (!strcmp(layout, "mono")) { return 1; }
+    if (!strcmp(layout, "stereo")) { return 2; }
+    return 6;
+}
+
+// 返回 0 表示完成，1 表示引擎不可用（例如 FFmpeg 没有启用 libsoxr）
+static int32_t run_case(
+    const RatePair &pair,
+    const char *fmt_name,
+    const char *layout,
+    const EngineCase &engine_case,
+    int32_t seconds) {
+    enum AVSampleFormat fmt = av_get_sample_fmt(fmt_name);
+    int32_t channels = layout_channels(layout);
+    int32_t bytes = av_get_bytes_per_sample(fmt);
+    int64_t nb_input = (int64_t)pair.in_rate * seconds;
+    std::vector<Tone> tones = test_tones(pair);
+
+    std::vector<uint8_t> input((size_t)nb_input * channels * bytes);
+    for (int64_t i = 0; i < nb_input; i++) {
+        for (int32_t ch = 0; ch < channels; ch++) {
+            store_sample(
+                input.data() + ((size_t)i * channels + ch) * bytes, fmt,
+                tone_value(tones, (double)i / pair.in_rate, ch, false));
+        }
+    }
+
+    if (init_audio_resampler(
+            pair.in_rate, fmt_name, layout, pair.out_rate, fmt_name, layout, engine_case.engine, engine_case.quality)
+        < 0) {
+        destroy_audio_resampler();
+        return 1;
+    }
+
+    std::vector<uint8_t> output;
+    output.reserve((size_t)(nb_input * pair.out_rate / pair.in_rate + CHUNK_SAMPLES) * channels * bytes);
+    set_audio_resampler_output([&](const uint8_t *data, int32_t nb_samples) -> int32_t {
+        output.insert(output.end(), data, data + (size_t)nb_samples * channels * bytes);
+        return 0;
+    });
+
+    int32_t result = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < nb_input && result >= 0; i += CHUNK_SAMPLES) {
+        int32_t nb_samples = (int32_t)(nb_input - i < CHUNK_SAMPLES ? nb_input - i : CHUNK_SAMPLES);
+        result = resample_samples(input.data() + (size_t)i * channels * bytes, nb_samples);
+    }
+    if (result >= 0) { result = resample_samples(nullptr, 0); }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    destroy_audio_resampler();
+    if (result < 0) { return -1; }
+
+    // 只统计中间部分，跳过首尾滤波器的过渡段
+    int64_t nb_output = (int64_t)(output.size() / ((size_t)channels * bytes));
+    double signal = 0, noise = 0;
+    for (int64_t i = nb_output / 10; i < nb_output - nb_output / 10; i++) {
+        for (int32_t ch = 0; ch < channels; ch++) {
+            double expected = tone_value(tones, (double)i / pair.out_rate, ch, true);
+            double error = load_sample(output.data() + ((size_t)i * channels + ch) * bytes, fmt) - expected;
+            signal += expected * expected;
+            noise += error * error;
+        }
+    }
+    double snr = noise > 0 ? 10 * log10(signal / noise) : 999.0;
+
+    std::cout << pair.in_rate << "->" << pair.out_rate << "\t" << fmt_name << "\t" << layout << "\t"
+              << engine_case.engine << "/" << engine_case.quality << "\t" << nb_input / elapsed / 1e6 << "\t"
+              << nb_input / elapsed / pair.in_rate << "\t" << snr << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int32_t seconds = argc > 1 ? atoi(argv[1]) : 10;
+
+    std::cout << "rates\tformat\tlayout\tengine\tMsamples/s\trealtime\tSNR(dB)" << std::endl;
+    for (size_t r = 0; r < sizeof(rate_pairs) / sizeof(rate_pairs[0]); r++) {
+        for (size_t f = 0; f < sizeof(sample_fmts) / sizeof(sample_fmts[0]); f++) {
+            for (size_t l = 0; l < sizeof(ch_layouts) / sizeof(ch_layouts[0]); l++) {
+                for (size_t e = 0; e < sizeof(engine_cases) / sizeof(engine_cases[0]); e++) {
+                    int32_t result = run_case(rate_pairs[r], sample_fmts[f], ch_layouts[l], engine_cases[e], seconds);
+                    if (result < 0) { return -1; }
+                    if (result > 0) {
+                        std::cout << engine_cases[e].engine << "/" << engine_cases[e].quality << " unavailable"
+                                  << std::endl;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "audio_resampler_core.h"
+#include "io_data.h"
+
+// 检查 audio_resample_parallel 与串行的 audio_resample 输出逐字节一致。块长取得很短，
+// 让一次运行中出现多轮、多个块边界；输出用 flt，避免 s16 的量化掩盖边界处的微小差异。失败时返回非 0。
+#define INPUT_FRAMES  144000 // 48kHz 下 3 秒
+#define CHUNK_SECONDS 0.25
+#define NB_THREADS    4
+#define INPUT_FILE    "audio_resample_parallel_test.pcm"
+
+struct ResampleCase {
+    int32_t in_rate;
+    int32_t out_rate;
+};
+
+static const ResampleCase resample_cases[] = {{44100, 48000}, {48000, 16000}};
+static const char *qualities[] = {"low", "medium", "high"};
+
+// s16 立体声交错：扫频正弦加伪随机噪声，覆盖整个频带
+static int32_t write_test_input() {
+    FILE *file = fopen(INPUT_FILE, "wb");
+    if (!file) { return -1; }
+    std::vector<int16_t> samples(INPUT_FRAMES * 2);
+    uint32_t seed = 1;
+    double phase = 0;
+    for (int32_t i = 0; i < INPUT_FRAMES; i++) {
+        phase += 2 * M_PI * (50.0 + 20000.0 * i / INPUT_FRAMES) / 48000.0;
+        seed = seed * 1103515245 + 12345;
+        double noise = ((int32_t)(seed >> 16) % 2000 - 1000) / 1000.0;
+        samples[i * 2] = (int16_t)(12000 * sin(phase) + 3000 * noise);
+        samples[i * 2 + 1] = (int16_t)(12000 * cos(phase * 0.5) - 3000 * noise);
+    }
+    size_t written = fwrite(samples.data(), sizeof(int16_t), samples.size(), file);
+    fclose(file);
+    return written == samples.size() ? 0 : -1;
+}
+
+static int32_t run_resample(
+    const ResampleCase &resample_case,
+    const char *quality,
+    bool parallel,
+    std::vector<uint8_t> &output) {
+    output.clear();
+    int32_t result = open_input_file(INPUT_FILE);
+    if (result >= 0) {
+        result = init_audio_resampler(
+            resample_case.in_rate, "s16", "stereo", resample_case.out_rate, "flt", "stereo", "swr", quality);
+    }
+    if (result >= 0) {
+        set_audio_resampler_output([&output](const uint8_t *data, int32_t nb_samples) {
+            output.insert(output.end(), data, data + (size_t)nb_samples * 2 * sizeof(float));
+            return 0;
+        });
+        result = parallel ? audio_resample_parallel(NB_THREADS, CHUNK_SECONDS) : audio_resample();
+    }
+    destroy_audio_resampler();
+    close_input_output_files();
+    return result;
+}
+
+static int32_t check_case(const ResampleCase &resample_case, const char *quality) {
+    std::vector<uint8_t> serial, parallel;
+    if (run_resample(resample_case, quality, false, serial) < 0
+        || run_resample(resample_case, quality, true, parallel) < 0) {
+        std::cerr << "FAIL " << resample_case.in_rate << " -> " << resample_case.out_rate << ": resample failed."
+                  << std::endl;
+        return -1;
+    }
+
+    size_t first_diff = 0;
+    while (first_diff < serial.size() && first_diff < parallel.size() && serial[first_diff] == parallel[first_diff]) {
+        first_diff++;
+    }
+    bool ok = !serial.empty() && serial.size() == parallel.size() && first_diff == serial.size();
+    std::cout << (ok ? "PASS " : "FAIL ") << resample_case.in_rate << " -> " << resample_case.out_rate << " "
+              << quality << ": samples:" << serial.size() / (2 * sizeof(float)) << "/"
+              << parallel.size() / (2 * sizeof(float));
+    if (!ok) { std::cout << ", first difference at sample " << first_diff / (2 * sizeof(float)); }
+    std::cout << std::endl;
+    return ok ? 0 : -1;
+}
+
+int main() {
+    if (write_test_input() < 0) {
+        std::cerr << "Error: failed to write test input." << std::endl;
+        return 1;
+    }
+
+    int32_t failed = 0;
+    for (size_t c = 0; c < sizeof(resample_cases) / sizeof(resample_cases[0]); c++) {
+        for (size_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++) {
+            failed += check_case(resample_cases[c], qualities[q]) < 0;
+        }
+    }
+
+    remove(INPUT_FILE);
+    return failed ? 1 : 0;
+}
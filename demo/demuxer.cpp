@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -6,7 +7,10 @@
 
 static void usage(const char *program_name) {
     std::cout << "usage: " << std::string(program_name)
-              << " input_file output_video_file output_audio_file "
+              << " input_file output_video_file output_audio_file [copy]"
+              << std::endl;
+    std::cout << "  copy: write h264/hevc (Annex B) and aac (ADTS) "
+                 "elementary streams without decoding"
               << std::endl;
 }
 
@@ -16,7 +20,8 @@ int main(int argc, char **argv) {
         return 1;
     }
     do {
-        int32_t result = init_demuxer(argv[1], argv[2], argv[3]);
+        bool copy = argc > 4 && !strcmp(argv[4], "copy");
+        int32_t result = init_demuxer(argv[1], argv[2], argv[3], copy);
         if (result < 0) { break; }
         result = demuxing(argv[2], argv[3]);
     } while (0);
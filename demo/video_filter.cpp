@@ -2,16 +2,17 @@
 #include <iostream>
 #include <string>
 
+#include "filter_graph_cache.h"
 #include "io_data.h"
 #include "video_filter_core.h"
 
 static void usage(const char *program_name) {
-    std::cout << "usage: " << std::string(program_name) << " input_file pic_width pic_height pix_fmt filter_discr"
+    std::cout << "usage: " << std::string(program_name) << " input_file pic_width pic_height frame_cnt filter_discr output_file [nb_threads] [pool] [jobs]"
               << std::endl;
 }
 
 int main(int argc, char **argv) {
-    if (argc < 6) {
+    if (argc < 7) {
         usage(argv[0]);
         return 1;
     }
@@ -22,20 +23,32 @@ int main(int argc, char **argv) {
     int32_t total_frame_cnt = atoi(argv[4]);
     char *filter_descr = argv[5];
     char *output_file_name = argv[6];
+    int32_t nb_threads = argc > 7 ? atoi(argv[7]) : 0;
+    bool use_thread_pool = argc > 8 && std::string(argv[8]) == "pool";
+    // 多次重复同一任务模拟批量短视频处理，第二个任务起复用缓存的滤镜图
+    int32_t jobs = argc > 9 ? atoi(argv[9]) : 1;
+    enable_video_filter_graph_cache(jobs > 1);
+
+    int32_t result = 0;
+    for (int32_t job = 0; result >= 0 && job < jobs; job++) {
+        result = open_input_output_files(input_file_name, output_file_name);
+        do {
+            if (result < 0) { break; }
+
+            result = init_video_filter(pic_width, pic_height, filter_descr, nb_threads, "slice", use_thread_pool);
+            if (result < 0) { break; }
+
+            result = filter_video(total_frame_cnt);
+            if (result < 0) { break; }
+        } while (0);
+
+        close_input_output_files();
+        print_video_filter_stats();
+        destroy_video_filter();
+    }
 
-    int32_t result = open_input_output_files(input_file_name, output_file_name);
-    do {
-        if (result < 0) { break; }
-
-        result = init_video_filter(pic_width, pic_height, filter_descr);
-        if (result < 0) { break; }
-
-        result = filter_video(total_frame_cnt);
-        if (result < 0) { break; }
-    } while (0);
-
-    close_input_output_files();
-    destroy_video_filter();
+    if (jobs > 1) { print_filter_graph_cache_stats(); }
+    clear_filter_graph_cache();
 
     return result;
 }
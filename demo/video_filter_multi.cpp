@@ -0,0 +1,93 @@
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "io_data.h"
+#include "video_filter_core.h"
+
+// 一次滤镜图处理产生多路输出，每路写入 output_prefix_<name>.yuv。例如 output_names 为
+// "preview,thumb,master"，filter_discr 为
+// "split=3[a][b][c];[a]scale=640:-2[preview];[b]scale=160:-2[thumb];[c]drawbox=x=20:y=20:w=200:h=60[master]"
+
+static void usage(const char *program_name) {
+    std::cout << "usage: " << std::string(program_name)
+              << " input_file pic_width pic_height frame_cnt filter_discr output_prefix output_names" << std::endl;
+}
+
+static int32_t write_frame_to(FILE *file, const AVFrame *frame) {
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((enum AVPixelFormat)frame->format);
+    for (int32_t plane = 0; plane < 3; plane++) {
+        int32_t width = plane ? AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w) : frame->width;
+        int32_t height = plane ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        for (int32_t y = 0; y < height; y++) {
+            if (fwrite(frame->data[plane] + y * frame->linesize[plane], 1, width, file) != (size_t)width) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 8) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char *input_file_name = argv[1];
+    int32_t pic_width = atoi(argv[2]);
+    int32_t pic_height = atoi(argv[3]);
+    int32_t total_frame_cnt = atoi(argv[4]);
+    char *filter_descr = argv[5];
+    std::string output_prefix(argv[6]);
+    std::string output_names(argv[7]);
+
+    std::vector<FILE *> output_files;
+    int32_t result = open_input_output_files(input_file_name, "/dev/null");
+    do {
+        if (result < 0) { break; }
+
+        size_t start = 0;
+        while (start < output_names.size()) {
+            size_t end = output_names.find(',', start);
+            if (end == std::string::npos) { end = output_names.size(); }
+            std::string name = output_names.substr(start, end - start);
+            start = end + 1;
+
+            std::string file_name = output_prefix + "_" + name + ".yuv";
+            FILE *file = fopen(file_name.c_str(), "wb");
+            if (!file) {
+                std::cerr << "Error: open output file " << file_name << " failed." << std::endl;
+                result = -1;
+                break;
+            }
+            output_files.push_back(file);
+
+            result =
+                add_video_filter_output(name.c_str(), [file](AVFrame *frame) { return write_frame_to(file, frame); });
+            if (result < 0) { break; }
+        }
+        if (result < 0) { break; }
+
+        result = init_video_filter(pic_width, pic_height, filter_descr);
+        if (result < 0) { break; }
+
+        result = filter_video(total_frame_cnt);
+        if (result < 0) { break; }
+    } while (0);
+
+    close_input_output_files();
+    print_video_filter_stats();
+    destroy_video_filter();
+    for (size_t i = 0; i < output_files.size(); i++) { fclose(output_files[i]); }
+
+    return result;
+}
@@ -0,0 +1,113 @@
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "filter_graph_cache.h"
+#include "io_data.h"
+#include "video_filter_core.h"
+
+// 同一个滤镜描述连续运行两个任务，检查滤镜图缓存：
+// 无状态的滤镜图第二次命中缓存且输出与第一次完全相同；有状态的滤镜图（fps）和 reusable = false 的任务
+// 不进入缓存，结束时经 EOF 冲刷，两次输出同样一致。失败时返回非 0。
+#define WIDTH 320
+#define HEIGHT 240
+#define FRAME_CNT 10
+#define INPUT_FILE "video_filter_reuse_test.yuv"
+
+struct FrameRecord {
+    int64_t pts;
+    uint64_t hash;
+};
+
+static int32_t write_test_input() {
+    FILE *file = fopen(INPUT_FILE, "wb");
+    if (!file) { return -1; }
+    std::vector<uint8_t> picture(WIDTH * HEIGHT * 3 / 2);
+    for (int32_t i = 0; i < FRAME_CNT; i++) {
+        for (size_t j = 0; j < picture.size(); j++) { picture[j] = (uint8_t)(j * 7 + i * 13); }
+        fwrite(picture.data(), 1, picture.size(), file);
+    }
+    fclose(file);
+    return 0;
+}
+
+static uint64_t hash_frame(const AVFrame *frame) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int32_t plane = 0; plane < 3; plane++) {
+        int32_t width = plane ? frame->width / 2 : frame->width;
+        int32_t height = plane ? frame->height / 2 : frame->height;
+        for (int32_t y = 0; y < height; y++) {
+            const uint8_t *row = frame->data[plane] + y * frame->linesize[plane];
+            for (int32_t x = 0; x < width; x++) { hash = (hash ^ row[x]) * 1099511628211ULL; }
+        }
+    }
+    return hash;
+}
+
+static int32_t run_job(const char *filter_describe, bool reusable, std::vector<FrameRecord> &records) {
+    records.clear();
+    int32_t result = open_input_output_files(INPUT_FILE, "/dev/null");
+    if (result >= 0) {
+        result = add_video_filter_output("out", [&records](AVFrame *frame) {
+            records.push_back({frame->pts, hash_frame(frame)});
+            return 0;
+        });
+    }
+    if (result >= 0) { result = init_video_filter(WIDTH, HEIGHT, filter_describe, 1, "none", false, reusable); }
+    if (result >= 0) { result = filter_video(FRAME_CNT); }
+    close_input_output_files();
+    destroy_video_filter();
+    return result;
+}
+
+static bool same_output(const std::vector<FrameRecord> &first, const std::vector<FrameRecord> &second) {
+    if (first.size() != second.size()) { return false; }
+    for (size_t i = 0; i < first.size(); i++) {
+        if (first[i].pts != second[i].pts || first[i].hash != second[i].hash) { return false; }
+    }
+    return true;
+}
+
+// expect_cached 为 true 时第二个任务应命中缓存，否则两个任务都应新建滤镜图且结束时被释放
+static int32_t check_case(const char *filter_describe, bool reusable, bool expect_cached, size_t min_frames) {
+    std::vector<FrameRecord> first, second;
+    FilterGraphCacheStats before, after;
+    get_filter_graph_cache_stats(before);
+
+    if (run_job(filter_describe, reusable, first) < 0 || run_job(filter_describe, reusable, second) < 0) {
+        std::cerr << "FAIL " << filter_describe << ": job failed." << std::endl;
+        return -1;
+    }
+    get_filter_graph_cache_stats(after);
+
+    uint64_t hits = after.hits - before.hits, discards = after.discards - before.discards;
+    bool ok = same_output(first, second) && first.size() >= min_frames;
+    ok = ok && (expect_cached ? hits == 1 && after.idle == 1 : hits == 0 && discards == 2);
+    std::cout << (ok ? "PASS " : "FAIL ") << filter_describe << (reusable ? "" : " (reusable=false)")
+              << ": frames:" << first.size() << "/" << second.size() << ", hits:" << hits << ", discards:" << discards
+              << std::endl;
+    clear_filter_graph_cache();
+    return ok ? 0 : -1;
+}
+
+int main() {
+    if (write_test_input() < 0) {
+        std::cerr << "Error: failed to write test input." << std::endl;
+        return 1;
+    }
+    enable_video_filter_graph_cache(true);
+
+    int32_t failed = 0;
+    failed += check_case("scale=160:120,hflip", true, true, FRAME_CNT) < 0;
+    failed += check_case("scale=160:120,hflip", false, false, FRAME_CNT) < 0;
+    // 25fps 转 50fps，最后一个输入帧对应的两个输出帧只有在 EOF 冲刷时才会输出
+    failed += check_case("fps=fps=50", true, false, 2 * FRAME_CNT) < 0;
+
+    remove(INPUT_FILE);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,68 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "io_data.h"
+#include "video_filter_core.h"
+#include "video_native_stage.h"
+
+// 原生阶段与 libavfilter 滤镜图组合使用，例如把裁剪和翻转放在滤镜图之前、叠加水印放在之后：
+// pre_stages 为 "crop=1280:720:320:180,hflip"，filter_discr 为 "null"，
+// post_stages 为 "overlay=logo_200x60.yuva:200:60:20:20"。各阶段用逗号分隔，"-" 表示不使用。
+
+static void usage(const char *program_name) {
+    std::cout << "usage: " << std::string(program_name)
+              << " input_file pic_width pic_height frame_cnt pre_stages filter_discr post_stages output_file"
+              << std::endl;
+}
+
+static int32_t add_stages(const std::string &describe, const char *output) {
+    if (describe == "-") { return 0; }
+    size_t start = 0;
+    while (start < describe.size()) {
+        size_t end = describe.find(',', start);
+        if (end == std::string::npos) { end = describe.size(); }
+        VideoStage *stage = create_video_stage(describe.substr(start, end - start).c_str());
+        if (!stage || add_video_filter_stage(stage, output) < 0) { return -1; }
+        start = end + 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 9) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char *input_file_name = argv[1];
+    int32_t pic_width = atoi(argv[2]);
+    int32_t pic_height = atoi(argv[3]);
+    int32_t total_frame_cnt = atoi(argv[4]);
+    char *filter_descr = argv[6];
+    char *output_file_name = argv[8];
+
+    int32_t result = open_input_output_files(input_file_name, output_file_name);
+    do {
+        if (result < 0) { break; }
+
+        result = add_stages(argv[5], nullptr);
+        if (result < 0) { break; }
+
+        // 不注册输出时滤镜图只有默认的 "out" 输出
+        result = add_stages(argv[7], "out");
+        if (result < 0) { break; }
+
+        result = init_video_filter(pic_width, pic_height, filter_descr);
+        if (result < 0) { break; }
+
+        result = filter_video(total_frame_cnt);
+        if (result < 0) { break; }
+    } while (0);
+
+    close_input_output_files();
+    print_video_filter_stats();
+    destroy_video_filter();
+
+    return result;
+}
@@ -3,12 +3,13 @@
 #include <string>
 
 #include "io_data.h"
+#include "sws_context_cache.h"
 #include "video_swscale_core.h"
 
 static void usage(const char *program_name) {
     std::cout << "usage: " << std::string(program_name)
               << " input_file input_size in_pix_fmt in_layout output_file "
-                 "output_size out_pix_fmt out_layout "
+                 "output_size out_pix_fmt out_layout [threads] [algorithm]"
               << std::endl;
 }
 
@@ -25,11 +26,13 @@ int main(int argc, char **argv) {
     char *output_file_name = argv[4];
     char *output_pic_size = argv[5];
     char *output_pix_fmt = argv[6];
+    int32_t threads = argc > 7 ? atoi(argv[7]) : 1;
+    const char *algorithm = argc > 8 ? argv[8] : "bilinear";
 
     do {
         result = open_input_output_files(input_file_name, output_file_name);
         if (result < 0) { break; }
-        result = init_video_swscale(input_pic_size, input_pix_fmt, output_pic_size, output_pix_fmt);
+        result = init_video_swscale(input_pic_size, input_pix_fmt, output_pic_size, output_pix_fmt, threads, algorithm);
         if (result < 0) { break; }
         result = transform(100);
         if (result < 0) { break; }
@@ -37,6 +40,8 @@ int main(int argc, char **argv) {
 
     destroy_video_swscale();
     close_input_output_files();
+    print_sws_cache_stats();
+    clear_sws_cache();
 
     return result;
 }
@@ -0,0 +1,105 @@
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "sws_context_cache.h"
+#include "video_swscale_core.h"
+
+// 合成一帧 YUV420P 测试图像：亮度为斜向渐变，色度为水平/垂直渐变
+static int32_t fill_test_frame(AVFrame *frame, int32_t width, int32_t height) {
+    frame->width = width;
+    frame->height = height;
+    frame->format = AV_PIX_FMT_YUV420P;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        std::cerr << "Error: could not get AVFrame buffer." << std::endl;
+        return -1;
+    }
+
+    for (int32_t y = 0; y < height; y++) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int32_t x = 0; x < width; x++) { row[x] = (uint8_t)((x + y) & 0xff); }
+    }
+    for (int32_t y = 0; y < height / 2; y++) {
+        uint8_t *u_row = frame->data[1] + y * frame->linesize[1];
+        uint8_t *v_row = frame->data[2] + y * frame->linesize[2];
+        for (int32_t x = 0; x < width / 2; x++) {
+            u_row[x] = (uint8_t)(x & 0xff);
+            v_row[x] = (uint8_t)(y & 0xff);
+        }
+    }
+    return 0;
+}
+
+static int32_t run_case(const char *src_size, const char *dst_size, int32_t threads, int32_t frame_cnt) {
+    std::string src(src_size), dst(dst_size), fmt("YUV420P");
+    int32_t width = 0, height = 0;
+    if (sscanf(src_size, "%dx%d", &width, &height) != 2) { return -1; }
+
+    AVFrame *src_frame = av_frame_alloc();
+    AVFrame *dst_frame = av_frame_alloc();
+    int32_t result = 0;
+    do {
+        if (!src_frame || !dst_frame) {
+            result = -1;
+            break;
+        }
+        result = fill_test_frame(src_frame, width, height);
+        if (result < 0) { break; }
+
+        result = init_video_swscale(&src[0], &fmt[0], &dst[0], &fmt[0], threads);
+        if (result < 0) { break; }
+
+        // 预热一帧，同时让 sws_scale_frame 分配输出缓冲区
+        result = scale_video_frame(src_frame, dst_frame);
+        if (result < 0) { break; }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < frame_cnt && result >= 0; i++) { result = scale_video_frame(src_frame, dst_frame); }
+        auto end = std::chrono::steady_clock::now();
+        if (result < 0) { break; }
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << src << " -> " << dst << ", threads:" << threads << ", fps:" << frame_cnt / seconds << std::endl;
+    } while (0);
+
+    destroy_video_swscale();
+    av_frame_free(&src_frame);
+    av_frame_free(&dst_frame);
+    return result;
+}
+
+static void usage(const char *program_name) {
+    std::cout << "usage: " << std::string(program_name) << " [frame_cnt] [max_threads]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "-h") {
+        usage(argv[0]);
+        return 0;
+    }
+    int32_t frame_cnt = argc > 1 ? atoi(argv[1]) : 50;
+    int32_t max_threads = argc > 2 ? atoi(argv[2]) : 8;
+
+    const char *cases[][2] = {
+        {"1920x1080", "3840x2160"},
+        {"3840x2160", "1280x720"},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        for (int32_t threads = 1; threads <= max_threads; threads *= 2) {
+            if (run_case(cases[i][0], cases[i][1], threads, frame_cnt) < 0) {
+                std::cerr << "Error: benchmark case failed." << std::endl;
+                return -1;
+            }
+        }
+    }
+    print_sws_cache_stats();
+    clear_sws_cache();
+    return 0;
+}
@@ -0,0 +1,82 @@
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/parseutils.h>
+}
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "io_data.h"
+#include "sws_context_cache.h"
+#include "video_encoder_core.h"
+#include "video_swscale_core.h"
+
+static void usage(const char *program_name) {
+    std::cout << "usage: " << std::string(program_name)
+              << " input_yuv input_size output_file codec_name[libx264] frame_cnt [threads]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 6) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    char *input_file_name = argv[1];
+    char *input_pic_size = argv[2];
+    char *output_file_name = argv[3];
+    char *codec_name = argv[4];
+    int32_t frame_cnt = atoi(argv[5]);
+    int32_t threads = argc > 6 ? atoi(argv[6]) : 1;
+
+    // 编码器固定为 1280x720 YUV420P，缩放结果直接按引用送入编码器，中间不落盘也不拷贝
+    char pix_fmt[] = "YUV420P";
+    char encoder_size[] = "1280x720";
+
+    AVFrame *input_frame = av_frame_alloc();
+    AVFrame *scaled_frame = av_frame_alloc();
+    int32_t result = 0;
+    do {
+        if (!input_frame || !scaled_frame) {
+            result = -1;
+            break;
+        }
+        result = open_input_output_files(input_file_name, output_file_name);
+        if (result < 0) { break; }
+        result = init_video_encoder(codec_name);
+        if (result < 0) { break; }
+        result = init_video_swscale(input_pic_size, pix_fmt, encoder_size, pix_fmt, threads);
+        if (result < 0) { break; }
+
+        input_frame->format = AV_PIX_FMT_YUV420P;
+        result = av_parse_video_size(&input_frame->width, &input_frame->height, input_pic_size);
+        if (result < 0) { break; }
+        result = av_frame_get_buffer(input_frame, 0);
+        if (result < 0) { break; }
+
+        for (int32_t i = 0; i < frame_cnt; i++) {
+            result = read_yuv_to_frame(input_frame);
+            if (result < 0) { break; }
+            input_frame->pts = i;
+
+            result = scale_to_pooled_frame(input_frame, scaled_frame);
+            if (result < 0) { break; }
+            result = encode_video_frame(scaled_frame);
+            av_frame_unref(scaled_frame);
+            if (result < 0) { break; }
+        }
+        if (result < 0) { break; }
+
+        result = encode_video_frame(nullptr);
+    } while (0);
+
+    av_frame_free(&input_frame);
+    av_frame_free(&scaled_frame);
+    destroy_video_swscale();
+    destroy_video_encoder();
+    close_input_output_files();
+    clear_sws_cache();
+
+    return result;
+}
@@ -0,0 +1,114 @@
+extern "C" {
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "sws_context_cache.h"
+#include "video_scale_kernels.h"
+
+// 专用内核与 libswscale(bilinear) 在同一转换上的速度对比，包括仍为标量实现的 RGB24 内核；
+// 最后汇总比 libswscale 慢的内核，这样的内核应从分派表中去掉
+
+struct KernelCase {
+    int32_t src_width, src_height;
+    enum AVPixelFormat src_pix_fmt;
+    int32_t dst_width, dst_height;
+    enum AVPixelFormat dst_pix_fmt;
+};
+
+static const KernelCase kernel_cases[] = {
+    {1920, 1080, AV_PIX_FMT_YUV420P, 1920, 1080, AV_PIX_FMT_NV12},
+    {1920, 1080, AV_PIX_FMT_NV12, 1920, 1080, AV_PIX_FMT_YUV420P},
+    {1920, 1080, AV_PIX_FMT_YUV420P, 960, 540, AV_PIX_FMT_YUV420P},
+    {1920, 1080, AV_PIX_FMT_YUV420P, 480, 270, AV_PIX_FMT_YUV420P},
+    {1920, 1080, AV_PIX_FMT_RGB24, 1920, 1080, AV_PIX_FMT_YUV420P},
+    {1920, 1080, AV_PIX_FMT_YUV420P, 1920, 1080, AV_PIX_FMT_RGB24},
+};
+
+static AVFrame *alloc_frame(int32_t width, int32_t height, enum AVPixelFormat pix_fmt) {
+    AVFrame *frame = av_frame_alloc();
+    if (!frame) { return nullptr; }
+    frame->width = width;
+    frame->height = height;
+    frame->format = pix_fmt;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    return frame;
+}
+
+// 用伪随机数据填充所有平面，包括行末填充
+static void fill_frame(AVFrame *frame) {
+    uint32_t seed = 1;
+    for (int32_t plane = 0; plane < 4 && frame->buf[plane]; plane++) {
+        for (size_t i = 0; i < frame->buf[plane]->size; i++) {
+            seed = seed * 1103515245 + 12345;
+            frame->buf[plane]->data[i] = (uint8_t)(seed >> 16);
+        }
+    }
+}
+
+static int32_t run_case(const KernelCase &kernel_case, int32_t iterations, int32_t &slower) {
+    const ScaleKernel *kernel = find_scale_kernel(
+        kernel_case.src_width, kernel_case.src_height, kernel_case.src_pix_fmt, kernel_case.dst_width,
+        kernel_case.dst_height, kernel_case.dst_pix_fmt, SWS_BILINEAR);
+    if (!kernel) {
+        std::cerr << "Error: no kernel for benchmark case." << std::endl;
+        return -1;
+    }
+
+    // 与 video_swscale_core 相同，RGB 转换按专用内核使用的 BT.709 系数
+    bool rgb = kernel_case.src_pix_fmt == AV_PIX_FMT_RGB24 || kernel_case.dst_pix_fmt == AV_PIX_FMT_RGB24;
+    struct SwsContext *sws_ctx = acquire_sws_context(
+        kernel_case.src_width, kernel_case.src_height, kernel_case.src_pix_fmt, kernel_case.dst_width,
+        kernel_case.dst_height, kernel_case.dst_pix_fmt, SWS_BILINEAR, 1, rgb ? SWS_CS_ITU709 : SWS_CS_DEFAULT);
+    AVFrame *src = alloc_frame(kernel_case.src_width, kernel_case.src_height, kernel_case.src_pix_fmt);
+    AVFrame *dst = alloc_frame(kernel_case.dst_width, kernel_case.dst_height, kernel_case.dst_pix_fmt);
+    int32_t result = (sws_ctx && src && dst) ? 0 : -1;
+
+    if (result == 0) {
+        fill_frame(src);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < iterations && result >= 0; i++) { result = sws_scale_frame(sws_ctx, dst, src); }
+        double sws_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < iterations && result >= 0; i++) { result = kernel->func(src, dst); }
+        double kernel_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (result >= 0) {
+            bool faster = kernel_seconds < sws_seconds;
+            std::cout << kernel->name << ": swscale fps:" << iterations / sws_seconds
+                      << ", kernel fps:" << iterations / kernel_seconds << ", speedup:" << sws_seconds / kernel_seconds
+                      << "x" << (faster ? "" : " (slower than libswscale)") << std::endl;
+            if (!faster) { slower++; }
+        }
+    }
+
+    release_sws_context(sws_ctx);
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    return result < 0 ? -1 : 0;
+}
+
+int main(int argc, char **argv) {
+    int32_t iterations = argc > 1 ? atoi(argv[1]) : 200;
+    int32_t slower = 0;
+    for (size_t i = 0; i < sizeof(kernel_cases) / sizeof(kernel_cases[0]); i++) {
+        if (run_case(kernel_cases[i], iterations, slower) < 0) { return -1; }
+    }
+    clear_sws_cache();
+    if (slower) {
+        std::cout << slower << " kernel(s) slower than libswscale." << std::endl;
+    } else {
+        std::cout << "All kernels faster than libswscale." << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/parseutils.h>
+#include <libswscale/swscale.h>
+}
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "io_data.h"
+#include "sws_context_cache.h"
+#include "video_swscale_core.h"
+
+// 缩放算法的速度与质量对比：合成图像按解析式在目标分辨率上直接渲染作为参考，
+// 真实图像没有理想参考，用 “缩放 -> 用同一算法缩放回原尺寸” 的往返误差衡量。
+// 指标只在亮度平面上计算。
+// 直接用 libswscale 缩放，不经过 video_swscale_core 对整数倍下采样的原生内核分派，每一行测的都是标注的算法。
+
+#define SUPERSAMPLE 4
+
+enum Pattern { PATTERN_SINES, PATTERN_RAMP, PATTERN_EDGES };
+
+static const char *pattern_names[] = {"sines", "ramp", "edges"};
+
+static const char *algorithms[] = {"fast_bilinear", "bilinear", "bicubic", "lanczos", "area", "spline"};
+
+struct ScaleCase {
+    const char *src_size;
+    const char *dst_size;
+};
+
+static const ScaleCase scale_cases[] = {
+    {"1920x1080", "1280x720"}, // 2/3 下采样
+    {"1920x1080", "960x540"},  // 1/2 下采样
+    {"1920x1080", "640x360"},  // 1/3 下采样
+    {"1920x1080", "480x270"},  // 1/4 下采样
+    {"1280x720", "1920x1080"}, // 1.5 倍上采样
+    {"960x540", "1920x1080"},  // 2 倍上采样
+};
+
+// 归一化坐标 (u, v) ∈ [0, 1) 上的连续图像，取值 [0, 255]
+static double pattern_value(Pattern pattern, double u, double v) {
+    switch (pattern) {
+        case PATTERN_SINES:
+            // 最高频率 61 周/画面，低于最小输出分辨率的奈奎斯特频率，参考图不会混叠
+            return 128.0 + 50.0 * sin(2 * M_PI * 3 * u) + 30.0 * sin(2 * M_PI * (17 * u + 11 * v))
+                   + 20.0 * sin(2 * M_PI * 61 * v);
+        case PATTERN_RAMP:
+            return 16.0 + 219.0 * (0.6 * u + 0.4 * v);
+        case PATTERN_EDGES: {
+            double du = u - 0.5, dv = (v - 0.5) * 9.0 / 16.0;
+            bool in_circle = du * du + dv * dv < 0.08;
+            bool in_check = ((int)(u * 8) + (int)(v * 6)) % 2 == 0;
+            return in_circle ? 235.0 : (in_check ? 180.0 : 40.0);
+        }
+    }
+    return 0;
+}
+
+// 每个像素取 SUPERSAMPLE x SUPERSAMPLE 个子样本的均值，即理想的面积平均
+static void render_pattern(Pattern pattern, AVFrame *frame) {
+    for (int32_t y = 0; y < frame->height; y++) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int32_t x = 0; x < frame->width; x++) {
+            double sum = 0;
+            for (int32_t sy = 0; sy < SUPERSAMPLE; sy++) {
+                for (int32_t sx = 0; sx < SUPERSAMPLE; sx++) {
+                    double u = (x + (sx + 0.5) / SUPERSAMPLE) / frame->width;
+                    double v = (y + (sy + 0.5) / SUPERSAMPLE) / frame->height;
+                    sum += pattern_value(pattern, u, v);
+                }
+            }
+            row[x] = (uint8_t)lrint(sum / (SUPERSAMPLE * SUPERSAMPLE));
+        }
+    }
+    for (int32_t plane = 1; plane < 3; plane++) {
+        for (int32_t y = 0; y < frame->height / 2; y++) {
+            memset(frame->data[plane] + y * frame->linesize[plane], 128, frame->width / 2);
+        }
+    }
+}
+
+static AVFrame *alloc_yuv_frame(const char *size) {
+    AVFrame *frame = av_frame_alloc();
+    if (!frame) { return nullptr; }
+    frame->format = AV_PIX_FMT_YUV420P;
+    if (av_parse_video_size(&frame->width, &frame->height, size) < 0 || av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    return frame;
+}
+
+static double luma_psnr(const AVFrame *a, const AVFrame *b) {
+    double sse = 0;
+    for (int32_t y = 0; y < a->height; y++) {
+        const uint8_t *ra = a->data[0] + y * a->linesize[0];
+        const uint8_t *rb = b->data[0] + y * b->linesize[0];
+        for (int32_t x = 0; x < a->width; x++) {
+            double d = (double)ra[x] - rb[x];
+            sse += d * d;
+        }
+    }
+    double mse = sse / ((double)a->width * a->height);
+    return mse > 0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+// 8x8 窗口、步长 4 的 SSIM 均值
+static double luma_ssim(const AVFrame *a, const AVFrame *b) {
+    const double c1 = (0.01 * 255) * (0.01 * 255), c2 = (0.03 * 255) * (0.03 * 255);
+    double total = 0;
+    int64_t windows = 0;
+    for (int32_t y = 0; y + 8 <= a->height; y += 4) {
+        for (int32_t x = 0; x + 8 <= a->width; x += 4) {
+            double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+            for (int32_t j = 0; j < 8; j++) {
+                const uint8_t *ra = a->data[0] + (y + j) * a->linesize[0] + x;
+                const uint8_t *rb = b->data[0] + (y + j) * b->linesize[0] + x;
+                for (int32_t i = 0; i < 8; i++) {
+                    sa += ra[i];
+                    sb += rb[i];
+                    saa += ra[i] * ra[i];
+                    sbb += rb[i] * rb[i];
+                    sab += ra[i] * rb[i];
+                }
+            }
+            double ma = sa / 64, mb = sb / 64;
+            double va = saa / 64 - ma * ma, vb = sbb / 64 - mb * mb, cov = sab / 64 - ma * mb;
+            total += ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+            windows++;
+        }
+    }
+    return windows ? total / windows : 1.0;
+}
+
+static struct SwsContext *acquire_scaler(const AVFrame *src, const AVFrame *dst, int32_t flags) {
+    return acquire_sws_context(
+        src->width, src->height, AV_PIX_FMT_YUV420P, dst->width, dst->height, AV_PIX_FMT_YUV420P, flags, 1);
+}
+
+// 返回输出百万像素每秒，SwsContext 的构建不计入
+static double time_scaling(const AVFrame *src, AVFrame *dst, int32_t flags, int32_t iterations) {
+    struct SwsContext *ctx = acquire_scaler(src, dst, flags);
+    if (!ctx) { return -1; }
+    auto start = std::chrono::steady_clock::now();
+    for (int32_t i = 0; i < iterations; i++) {
+        if (sws_scale_frame(ctx, dst, src) < 0) {
+            release_sws_context(ctx);
+            return -1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    release_sws_context(ctx);
+    return (double)dst->width * dst->height * iterations / seconds / 1e6;
+}
+
+// 用与正向相同的算法缩放回原尺寸
+static int32_t scale_back(const AVFrame *scaled, AVFrame *restored, int32_t flags) {
+    struct SwsContext *ctx = acquire_scaler(scaled, restored, flags);
+    if (!ctx) { return -1; }
+    int32_t result = sws_scale_frame(ctx, restored, scaled);
+    release_sws_context(ctx);
+    return result;
+}
+
+static void print_row(
+    const ScaleCase &scale_case,
+    const char *content,
+    const char *algorithm,
+    double mpps,
+    double psnr,
+    double ssim) {
+    printf("%-10s -> %-10s %-8s %-14s %10.1f %9.2f %8.5f\n", scale_case.src_size, scale_case.dst_size, content,
+           algorithm, mpps, psnr, ssim);
+}
+
+static int32_t run_synthetic(const ScaleCase &scale_case, Pattern pattern, int32_t iterations) {
+    AVFrame *src = alloc_yuv_frame(scale_case.src_size);
+    AVFrame *dst = alloc_yuv_frame(scale_case.dst_size);
+    AVFrame *reference = alloc_yuv_frame(scale_case.dst_size);
+    int32_t result = (src && dst && reference) ? 0 : -1;
+
+    if (result == 0) {
+        render_pattern(pattern, src);
+        render_pattern(pattern, reference);
+    }
+
+    for (size_t i = 0; result == 0 && i < sizeof(algorithms) / sizeof(algorithms[0]); i++) {
+        double mpps = time_scaling(src, dst, get_sws_algorithm_flags(algorithms[i]), iterations);
+        if (mpps < 0) { result = -1; }
+        if (result == 0) {
+            print_row(
+                scale_case, pattern_names[pattern], algorithms[i], mpps, luma_psnr(dst, reference),
+                luma_ssim(dst, reference));
+        }
+    }
+
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    av_frame_free(&reference);
+    return result;
+}
+
+static int32_t run_real(const ScaleCase &scale_case, AVFrame *src, int32_t iterations) {
+    AVFrame *dst = alloc_yuv_frame(scale_case.dst_size);
+    AVFrame *restored = alloc_yuv_frame(scale_case.src_size);
+    int32_t result = (dst && restored) ? 0 : -1;
+
+    for (size_t i = 0; result == 0 && i < sizeof(algorithms) / sizeof(algorithms[0]); i++) {
+        int32_t flags = get_sws_algorithm_flags(algorithms[i]);
+        double mpps = time_scaling(src, dst, flags, iterations);
+        if (mpps < 0) { result = -1; }
+        if (result == 0) { result = scale_back(dst, restored, flags); }
+        if (result == 0) {
+            print_row(scale_case, "real", algorithms[i], mpps, luma_psnr(src, restored), luma_ssim(src, restored));
+        }
+    }
+
+    av_frame_free(&dst);
+    av_frame_free(&restored);
+    return result < 0 ? -1 : 0;
+}
+
+static void usage(const char *program_name) {
+    std::cout << "usage: " << std::string(program_name) << " [iterations] [real_yuv_1920x1080 real_frame_cnt]"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::string(argv[1]) == "-h") {
+        usage(argv[0]);
+        return 0;
+    }
+    int32_t iterations = argc > 1 ? atoi(argv[1]) : 20;
+    const char *real_file = argc > 2 ? argv[2] : nullptr;
+    int32_t real_frame_cnt = argc > 3 ? atoi(argv[3]) : 1;
+
+    printf("%-10s    %-10s %-8s %-14s %10s %9s %8s\n", "src", "dst", "content", "algorithm", "Mpx/s", "PSNR(dB)",
+           "SSIM");
+
+    int32_t result = 0;
+    size_t nb_cases = sizeof(scale_cases) / sizeof(scale_cases[0]);
+    for (size_t c = 0; result == 0 && c < nb_cases; c++) {
+        for (int32_t p = PATTERN_SINES; result == 0 && p <= PATTERN_EDGES; p++) {
+            result = run_synthetic(scale_cases[c], (Pattern)p, iterations);
+        }
+    }
+
+    // 真实图像：从 1920x1080 YUV420P 文件中读取若干帧，只跑源尺寸为 1920x1080 的用例
+    if (result == 0 && real_file) {
+        char dummy_output[] = "/dev/null";
+        result = open_input_output_files(real_file, dummy_output);
+        AVFrame *src = alloc_yuv_frame("1920x1080");
+        if (!src) { result = -1; }
+        for (int32_t f = 0; result == 0 && f < real_frame_cnt; f++) {
+            result = read_yuv_to_frame(src);
+            for (size_t c = 0; result == 0 && c < nb_cases; c++) {
+                if (std::string(scale_cases[c].src_size) != "1920x1080") { continue; }
+                result = run_real(scale_cases[c], src, iterations);
+            }
+        }
+        av_frame_free(&src);
+        close_input_output_files();
+    }
+
+    clear_sws_cache();
+    if (result < 0) {
+        std::cerr << "Error: benchmark failed." << std::endl;
+        return -1;
+    }
+    return 0;
+}
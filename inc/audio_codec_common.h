@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/audio_fifo.h>
+#include <libswresample/swresample.h>
+}
+
+// 音频解码、编码和批量转码模块共用的编解码器查找、裸码流解析和 FIFO 写入
+
+// 先按编解码器名查找（如 "libopus"、"flac"），再按编码格式名查找（如 "mp3"、"ac3"），大小写不敏感。
+// 找不到或不是音频编解码器时返回 nullptr
+const AVCodec *find_audio_codec(const char *codec_name, bool encoder);
+
+// 读取最多 size 字节到 buf，返回读到的字节数；输入结束返回 0，出错返回负数
+using AudioInputReadCallback = std::function<int32_t(uint8_t *buf, int32_t size)>;
+// 每解析出一个数据包调用一次，返回负数时停止解析
+using AudioPacketCallback = std::function<int32_t(AVPacket *packet)>;
+
+// 用解析器把裸码流切分为数据包，直到输入结束且解析器中缓存的最后一帧也已取出。
+// 剩余数据低于阈值时把尾部移到缓冲区开头再补满，避免压缩帧被读取边界截断。
+// inbuf 由调用者持有，多个文件之间可以复用；不冲刷解码器
+int32_t parse_audio_stream(
+    AVCodecParserContext *parser,
+    AVCodecContext *codec_ctx,
+    AVPacket *packet,
+    std::vector<uint8_t> &inbuf,
+    const AudioInputReadCallback &read_input,
+    const AudioPacketCallback &on_packet);
+
+// 把样本转换为编码器的格式后写入 AVAudioFifo，由编码模块按帧长取出。
+// 输入格式与输出相同时直接写入，否则经 SwrContext 转换，输入参数变化时重建；转换缓冲区只在容量不足时重新分配。
+// FIFO 由调用者持有
+class AudioFifoWriter {
+public:
+    AudioFifoWriter() = default;
+    ~AudioFifoWriter();
+
+    AudioFifoWriter(const AudioFifoWriter &) = delete;
+    AudioFifoWriter &operator=(const AudioFifoWriter &) = delete;
+
+    // 输出参数必须与 fifo 的采样格式和声道数一致
+    int32_t init(
+        AVAudioFifo *fifo,
+        const AVChannelLayout *ch_layout,
+        enum AVSampleFormat sample_fmt,
+        int32_t sample_rate);
+    void uninit();
+    // 丢弃重采样器中的延迟样本，用于开始处理下一个文件
+    int32_t reset();
+
+    // 声明之后 write 送入的样本格式，与当前参数相同时什么也不做
+    int32_t set_input(const AVChannelLayout *ch_layout, enum AVSampleFormat sample_fmt, int32_t sample_rate);
+    bool converting() const { return swr_ctx_ != nullptr; }
+
+    // data 为 nullptr 时取出重采样器中的延迟样本
+    int32_t write(const uint8_t *const *data, int32_t nb_samples);
+    // 按帧的参数调用 set_input 后写入整帧
+    int32_t write_frame(const AVFrame *frame);
+
+private:
+    AVAudioFifo *fifo_ = nullptr;
+    AVChannelLayout out_ch_layout_ = {};
+    enum AVSampleFormat out_sample_fmt_ = AV_SAMPLE_FMT_NONE;
+    int32_t out_sample_rate_ = 0;
+
+    SwrContext *swr_ctx_ = nullptr;
+    AVChannelLayout in_ch_layout_ = {};
+    enum AVSampleFormat in_sample_fmt_ = AV_SAMPLE_FMT_NONE;
+    int32_t in_sample_rate_ = 0;
+
+    std::vector<uint8_t *> convert_planes_;
+    int32_t convert_capacity_ = 0;
+};
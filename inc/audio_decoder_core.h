@@ -2,6 +2,12 @@
 
 #include <cstdint>
 
-int32_t init_audio_decoder(const char *codec_name);
+// 可选的目标输出：ch_layout 如 "mono"/"stereo"，sample_fmt 如 "s16"/"fltp"，sample_rate 为 0 或参数为
+// nullptr 时沿用解码器的输出。转换在解码时逐帧完成，不需要再单独重采样
+int32_t init_audio_decoder(
+    const char *codec_name,
+    const char *ch_layout = nullptr,
+    int32_t sample_rate = 0,
+    const char *sample_fmt = nullptr);
 int32_t audio_decoding();
 void destroy_audio_decoder();
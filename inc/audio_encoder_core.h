@@ -3,6 +3,16 @@
 #include "audio_decoder_core.h"
 #include <stdint.h>
 
-int32_t init_audio_encoder(const char* codec_name);
+// 声明输入文件中交错 PCM 的格式（如 "s16" 48000 "stereo"），编码器优先直接使用这些参数，
+// 不支持时选用编码器的首选格式和最接近的采样率，读取时由 libswresample 一步转换
+int32_t init_audio_encoder(
+    const char *codec_name,
+    const char *sample_fmt = "flt",
+    int32_t sample_rate = 44100,
+    const char *ch_layout = "stereo");
 int32_t audio_encoding();
+// 送入任意数量的样本（init 时声明的输入格式），转换后凑满一帧即编码，pts 按样本数递增
+int32_t send_audio_samples(const uint8_t *const *data, int32_t nb_samples);
+// 编码 FIFO 中剩余的样本（编码器不支持短尾帧时补静音）并冲刷编码器
+int32_t flush_audio_encoder();
 void destroy_audio_encoder();
@@ -1,7 +1,25 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 
-int32_t init_audio_filter(char *volume_factor);
+struct AVFrame;
+
+// 输出帧回调，帧在回调返回后被 unref，需要保留时自行 av_frame_ref
+using AudioFilterOutputCallback = std::function<int32_t(AVFrame *frame)>;
+
+// 在 init_audio_filter 之前设置，替代默认的写入输出文件，例如只做分析、不需要输出样本的场景
+void set_audio_filter_output(const AudioFilterOutputCallback &callback);
+
+// filter_describe 为 "in" 到 "out" 之间的滤镜链，例如
+// "volume=0.5,aformat=sample_fmts=s16:sample_rates=22050:channel_layouts=mono"。
+// frame_size 为每次送入滤镜图的样本数：越小延迟越低，越大每个样本分摊的调用开销越少
+int32_t init_audio_filter(const char *filter_describe, int32_t frame_size = 4096);
 int32_t audio_filtering();
+// 不重建滤镜图的情况下修改滤镜参数：send 立即生效，queue 在时间戳 >= ts(秒) 的帧上生效
+int32_t send_audio_filter_command(const char *target, const char *cmd, const char *arg);
+int32_t queue_audio_filter_command(const char *target, const char *cmd, const char *arg, double ts);
+int32_t set_audio_volume(const char *volume, double ts = -1);
+// 输出样本数、处理耗时与相对实时的倍速，以及输入帧池大小
+void print_audio_filter_stats();
 void destroy_audio_filter();
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// EBU R128 测量结果
+struct LoudnessStats {
+    double integrated; // 整体响度，LUFS
+    double range;      // 响度范围，LU
+    double peak;       // 采样峰值，dBFS
+};
+
+// 第一遍：只读输入、用 ebur128 测量，不写任何输出。
+// 为了降低开销使用大帧、低阶重采样到 ebur128 要求的 48kHz，并用采样峰值代替真峰值
+int32_t analyze_loudness(const char *input_file, LoudnessStats &stats);
+
+// 旁路缓存为与输入同目录的 "<input_file>.loudness" 文本文件，记录输入文件的大小和修改时间，
+// 输入改变或缓存格式版本变化后缓存自动失效
+int32_t load_loudness_cache(const char *input_file, LoudnessStats &stats);
+int32_t save_loudness_cache(const char *input_file, const LoudnessStats &stats);
+
+// 整体增益 target_lufs - integrated，并限制在峰值不超过 peak_limit (dBFS)
+double compute_loudness_gain(const LoudnessStats &stats, double target_lufs, double peak_limit);
+
+// 第二遍：只用一个 volume 滤镜施加线性增益。缓存有效时跳过第一遍；
+// 换一个目标响度重新归一化只需要再调用一次，不会重新分析
+int32_t normalize_loudness(
+    const char *input_file,
+    const char *output_file,
+    double target_lufs,
+    double peak_limit = -1.0,
+    bool use_cache = true);
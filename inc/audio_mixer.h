@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+}
+
+#include "frame_pool.h"
+
+enum AudioMixerClipMode {
+    AUDIO_MIX_CLIP_NONE,  // 不处理，输出可能超出 [-1, 1]
+    AUDIO_MIX_CLIP_HARD,  // 硬削波到 [-threshold, threshold]
+    AUDIO_MIX_CLIP_LIMIT, // 按块压低整体增益并逐渐恢复，剩余的过冲再硬削波
+};
+
+// N 路 planar float 输入按 pts 对齐后加权求和，替代 amix 滤镜。
+// 所有输入与输出都是 FLTP，采样率和声道布局相同；pts 以 1/sample_rate 为时间基，输出从 0 开始。
+// 每路输入的缓冲在 init 时一次分配，处理过程中不再分配内存。不是线程安全的。
+class AudioMixer {
+public:
+    AudioMixer() = default;
+    ~AudioMixer();
+
+    AudioMixer(const AudioMixer &) = delete;
+    AudioMixer &operator=(const AudioMixer &) = delete;
+
+    // frame_size 为每个输出帧的样本数；capacity 为每路输入的缓冲样本数，不小于 frame_size
+    int32_t init(
+        int32_t nb_inputs,
+        int32_t sample_rate,
+        const AVChannelLayout &ch_layout,
+        int32_t frame_size,
+        int32_t capacity);
+    void uninit();
+
+    // 线性增益，默认 1.0
+    int32_t set_gain(int32_t input, float gain);
+    void set_clip_mode(AudioMixerClipMode mode, float threshold = 1.0f);
+
+    // 复制帧中的样本。缓冲放不下时返回 AVERROR(EAGAIN)，应先 receive_frame 取走输出再重试；
+    // 早于已输出位置的样本被丢弃，与前一帧之间的空隙补静音。frame 为 nullptr 表示该路输入结束
+    int32_t send_frame(int32_t input, const AVFrame *frame);
+
+    // 每路未结束的输入都覆盖了下一个输出块时输出一帧，否则返回 AVERROR(EAGAIN)；
+    // 全部输入结束且取空后返回 AVERROR_EOF。frame 来自内部帧池，用完后 unref
+    int32_t receive_frame(AVFrame *frame);
+
+private:
+    struct Input {
+        std::vector<float> samples; // 各声道的环形缓冲依次存放，每个 capacity_ 个样本
+        int64_t pts;                // 缓冲中第一个样本的时间戳
+        int32_t head;
+        int32_t count;
+        float gain;
+        bool finished;
+    };
+
+    void mix_input(Input &input, AVFrame *frame, int32_t nb_samples);
+    void apply_clip(AVFrame *frame, int32_t nb_samples);
+
+    std::vector<Input> inputs_;
+    FramePool output_pool_;
+    int32_t channels_ = 0;
+    int32_t sample_rate_ = 0;
+    int32_t frame_size_ = 0;
+    int32_t capacity_ = 0;
+    int64_t next_pts_ = 0;
+    AudioMixerClipMode clip_mode_ = AUDIO_MIX_CLIP_NONE;
+    float threshold_ = 1.0f;
+    float limiter_gain_ = 1.0f;
+};
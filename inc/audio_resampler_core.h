@@ -1,13 +1,38 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 
+// 输出回调，data 为交错存放的 nb_samples 个输出样本，只在回调期间有效
+using AudioResamplerOutputCallback = std::function<int32_t(const uint8_t *data, int32_t nb_samples)>;
+
+// 替代默认的写入输出文件，可在 init_audio_resampler 之前或之后设置
+void set_audio_resampler_output(const AudioResamplerOutputCallback &callback);
+
+// 样本格式为 libavutil 的格式名（s16、flt、dbl 等，planar 名按对应的交错格式处理）。
+// 声道布局为 libavutil 的布局描述（"stereo"、"5.1"、"7.1"、"ambisonic 1" 等）。
+// engine: "swr" 或 "soxr"（需要 FFmpeg 启用 libsoxr）；quality: "low"、"medium"、"high"；
+// matrix: 自定义声道混合矩阵，每个输出声道一行，行之间用 '|' 分隔，nullptr 时使用默认矩阵
 int32_t init_audio_resampler(
     int32_t in_sample_rate,
     const char *in_sample_fmt,
     const char *in_ch_layout,
     int32_t out_sample_rate,
     const char *out_sample_fmt,
-    const char *out_ch_layout);
-int32_t audio_resample();
+    const char *out_ch_layout,
+    const char *engine = "swr",
+    const char *quality = "medium",
+    const char *matrix = nullptr);
+// 流式接口：data 为交错存放的任意数量的输入样本，返回本次输出的样本数；
+// data 为 nullptr 时冲刷重采样器内部缓存的样本，流结束时必须调用一次
+int32_t resample_samples(const uint8_t *data, int32_t nb_samples);
+// 按 chunk_size 个样本读取输入文件并重采样，结束时自动冲刷
+int32_t audio_resample(int32_t chunk_size = 1152);
+// 把输入文件切成约 chunk_seconds 秒的块，用 nb_threads 个线程（<= 0 为 CPU 核数）各自重采样后按顺序拼接。
+// 相邻块之间重叠滤波器长度的输入，块边界对齐到输出相位为 0 的位置，swr 的结果与 audio_resample 一致
+// （依赖 swr 的延迟补偿与相位步进，由 audio_resample_parallel_test 逐字节检查）。
+// 内存占用约为 nb_threads 个块的输入与输出
+int32_t audio_resample_parallel(int32_t nb_threads, double chunk_seconds = 10.0);
+// 输入/输出样本数、重采样耗时与每秒处理的输入样本数
+void print_audio_resampler_stats();
 void destroy_audio_resampler();
\ No newline at end of file
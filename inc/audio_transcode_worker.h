@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "audio_codec_common.h"
+
+struct AudioTranscodeConfig {
+    std::string decoder_name; // 与 encoder_name 一样由 find_audio_codec 按编解码器名或编码格式名查找
+    std::string encoder_name;
+    int32_t sample_rate;
+    std::string ch_layout;
+    int64_t bit_rate;
+};
+
+// 单个工作线程持有的转码状态：解码器、编码器、重采样与 FIFO 在文件之间保持打开，
+// 每个文件结束后用 avcodec_flush_buffers 重置，省去每个文件重新查找和打开编解码器的开销。
+// 不是线程安全的，同一时刻只能被一个线程使用。
+class AudioTranscodeWorker {
+public:
+    AudioTranscodeWorker() = default;
+    ~AudioTranscodeWorker();
+
+    AudioTranscodeWorker(const AudioTranscodeWorker &) = delete;
+    AudioTranscodeWorker &operator=(const AudioTranscodeWorker &) = delete;
+
+    int32_t init(const AudioTranscodeConfig &config);
+    void uninit();
+    bool initialized() const { return enc_ctx_ != nullptr; }
+
+    // 裸码流输入（经解析器切分），编码后的数据包直接写入输出文件
+    int32_t transcode(const std::string &input_file, const std::string &output_file);
+
+private:
+    int32_t open_encoder();
+    int32_t reset();
+    int32_t decode_packet(const AVPacket *packet);
+    int32_t encode_from_fifo(bool flushing);
+    int32_t encode_frame(const AVFrame *input);
+
+    AudioTranscodeConfig config_;
+    const AVCodec *decoder_ = nullptr;
+    const AVCodec *encoder_ = nullptr;
+    AVCodecContext *dec_ctx_ = nullptr;
+    AVCodecContext *enc_ctx_ = nullptr;
+    AVCodecParserContext *parser_ = nullptr;
+    AVAudioFifo *fifo_ = nullptr;
+    AudioFifoWriter fifo_writer_;
+    AVFrame *decoded_frame_ = nullptr;
+    AVFrame *encode_frame_ = nullptr;
+    AVPacket *in_packet_ = nullptr;
+    AVPacket *out_packet_ = nullptr;
+    std::vector<uint8_t> inbuf_;
+    int32_t frame_size_ = 0;
+    FILE *output_ = nullptr;
+    int64_t next_pts_ = 0;
+    bool encoder_drained_ = false; // 编码器收到过冲刷信号，处理下一个文件前必须重置
+};
+
+struct AudioTranscodeJob {
+    std::string input_file;
+    std::string output_file;
+    int32_t result;
+    int64_t latency_us;
+};
+
+// 用 nb_workers 个线程（含调用线程）处理全部任务，每个线程复用自己的 AudioTranscodeWorker。
+// 单个文件失败只记录在对应任务的 result 中，返回失败的文件数
+int32_t run_audio_transcode_batch(
+    const AudioTranscodeConfig &config,
+    std::vector<AudioTranscodeJob> &jobs,
+    int32_t nb_workers);
+
+// 吞吐量（文件/秒）与单文件耗时的均值、中位数、P95 和最大值
+void print_audio_transcode_stats(const std::vector<AudioTranscodeJob> &jobs, int64_t wall_time_us);
@@ -2,6 +2,8 @@
 
 #include <cstdint>
 
-int32_t init_demuxer(const char *input_name, const char *video_output, const char *audio_output);
+// copy 为 true 时不解码，写出压缩的基本流：H.264/HEVC 为 Annex B，AAC 为 ADTS，
+// MP3/AC-3/E-AC-3 原样写出；缺少音频或视频流时只写出存在的那一路
+int32_t init_demuxer(const char *input_name, const char *video_output, const char *audio_output, bool copy = false);
 int32_t demuxing(const char *video_output_name, const char *audio_output_name);
 void destroy_demuxer();
\ No newline at end of file
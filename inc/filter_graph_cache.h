@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct AVFilterGraph;
+struct AVFilterContext;
+
+// 已配置完成的滤镜图及其端点，sink_ctxs 与构建时的输出顺序一致
+struct FilterGraphInstance {
+    AVFilterGraph *graph;
+    AVFilterContext *src_ctx;
+    std::vector<AVFilterContext *> sink_ctxs;
+};
+
+struct FilterGraphCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t discards;      // 归还时因不可复用而直接释放的次数
+    int64_t build_time_us;  // 所有 miss 解析并配置滤镜图的累计耗时
+    int64_t max_build_time_us;
+    int32_t idle;
+};
+
+typedef std::function<int32_t(FilterGraphInstance &instance)> FilterGraphBuilder;
+
+// key 需要唯一确定滤镜图：滤镜描述、输入尺寸与格式、输出标签、线程配置等。
+// 命中时直接借出空闲的滤镜图，否则调用 builder 解析并配置新的滤镜图。
+int32_t acquire_filter_graph(const std::string &key, const FilterGraphBuilder &builder, FilterGraphInstance &instance);
+
+// 滤镜图是否只由逐帧独立处理、不保留历史帧的滤镜组成（scale、crop、pad、drawbox 等）。
+// fps、tmix、yadif、overlay 等滤镜带有跨帧状态，无法重置，这类滤镜图不能复用。
+// 按帧求值且引用 n、t 的选项表达式同样依赖帧计数，不在检查范围内，调用者需自行避免
+bool is_filter_graph_reusable(const AVFilterGraph *graph);
+
+// 归还前会取空各 buffersink 中残留的帧。只有 reusable 为 true 且 is_filter_graph_reusable 的滤镜图
+// 才会进入缓存，其余直接释放；运行中修改过滤镜参数时应传 reusable = false。
+// 收到过 EOF 的滤镜图不能再接收帧，取空时 buffersink 返回 EOF，同样直接释放。
+void release_filter_graph(const std::string &key, FilterGraphInstance &instance, bool reusable);
+
+// 空闲滤镜图的上限，超出时按 LRU 淘汰
+void set_filter_graph_cache_capacity(int32_t capacity);
+void get_filter_graph_cache_stats(FilterGraphCacheStats &stats);
+void print_filter_graph_cache_stats();
+void clear_filter_graph_cache();
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 预分配的 AVFrame 池。池中每个帧自身持有一份缓冲区引用，get_frame 交给调用者的是新引用；
+// 调用者（或编码器、滤镜图等下游）释放所有引用后，缓冲区重新变为可写，即可再次借出。
+// 视频帧按 width/height/format，音频帧按 nb_samples/format/ch_layout/sample_rate 分配。
+class FramePool {
+public:
+    FramePool() = default;
+    ~FramePool();
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    // align 为 0 时使用 libavutil 默认的 SIMD 对齐
+    int32_t init(const AVFrame *frame_template, int32_t depth, int32_t align = 0);
+    void uninit();
+
+    // 取出一个空闲帧的引用放入 dst；所有帧都被占用时扩容一个，不会阻塞
+    int32_t get_frame(AVFrame *dst);
+
+    int32_t size();
+    int32_t available();
+
+private:
+    int32_t alloc_frame();
+
+    std::mutex mutex_;
+    std::vector<AVFrame *> frames_;
+    AVFrame *template_ = nullptr;
+    int32_t align_ = 0;
+    size_t next_ = 0;
+};
@@ -7,6 +7,8 @@ extern "C" {
 #include <stdint.h>
 
 int32_t open_input_output_files(const char *input_name, const char *output_name);
+// 只打开输入文件，用于不产生输出文件的分析流程
+int32_t open_input_file(const char *input_name);
 void close_input_output_files();
 
 int32_t end_of_input_file();
@@ -24,5 +26,6 @@ int32_t write_samples_to_pcm2(AVFrame *frame, enum AVSampleFormat format, int ch
 int32_t read_pcm_to_frame2(AVFrame *frame, enum AVSampleFormat format, int channels);
 
 void write_packed_data_to_file(const uint8_t* buf, int32_t size);
+int32_t write_image_to_file(const AVFrame *frame);
 
 #endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 单生产者单消费者的有界 AVPacket 队列，用于把解复用与各路流的解码放到不同线程。
+// 包数或字节数达到上限时 push 阻塞；队列为空时总是接受一个包，超过字节上限的单个大包不会卡住。
+class PacketQueue {
+public:
+    PacketQueue() = default;
+    ~PacketQueue();
+
+    PacketQueue(const PacketQueue &) = delete;
+    PacketQueue &operator=(const PacketQueue &) = delete;
+
+    int32_t init(int32_t max_packets, int64_t max_bytes);
+    void uninit();
+
+    // 取走 packet 的引用，返回后 packet 为空。队列被 abort 后返回 AVERROR_EXIT
+    int32_t push(AVPacket *packet);
+    // 阻塞直到取到一个包；finish 之后取空返回 AVERROR_EOF，abort 之后返回 AVERROR_EXIT
+    int32_t pop(AVPacket *packet);
+
+    // 生产者没有更多的包
+    void finish();
+    // 任一端出错时调用，唤醒并让两端的后续调用立即失败
+    void abort();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<AVPacket *> packets_;
+    int32_t max_packets_ = 0;
+    int64_t max_bytes_ = 0;
+    int64_t bytes_ = 0;
+    bool finished_ = false;
+    bool aborted_ = false;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+struct SwsCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    int64_t init_time_us;     // 所有 miss 构建 SwsContext 的累计耗时
+    int64_t max_init_time_us; // 单次构建的最大耗时
+    int32_t idle;             // 缓存中空闲的 SwsContext 数量
+    int32_t in_use;           // 已借出的 SwsContext 数量
+};
+
+// 按 (源宽高格式, 目标宽高格式, flags, threads, 色彩空间与范围) 借出一个 SwsContext，用完后需 release 归还。
+// 同一个 SwsContext 同时只会借给一个调用者，可以在多个线程中并发调用。
+// colorspace 为 SWS_CS_*，range 为 0（有限范围）或 1（全范围）；借出的上下文是共享的，
+// 调用者不能再用 sws_setColorspaceDetails 修改，需要不同的色彩参数时通过这里的参数指定。
+struct SwsContext *acquire_sws_context(
+    int32_t src_width,
+    int32_t src_height,
+    enum AVPixelFormat src_pix_fmt,
+    int32_t dst_width,
+    int32_t dst_height,
+    enum AVPixelFormat dst_pix_fmt,
+    int32_t flags,
+    int32_t threads,
+    int32_t colorspace = SWS_CS_DEFAULT,
+    int32_t src_range = 0,
+    int32_t dst_range = 0);
+void release_sws_context(struct SwsContext *ctx);
+
+// 空闲 SwsContext 的上限，超出时按 LRU 淘汰
+void set_sws_cache_capacity(int32_t capacity);
+void get_sws_cache_stats(SwsCacheStats &stats);
+void print_sws_cache_stats();
+void clear_sws_cache();
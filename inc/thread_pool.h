@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定大小的 work-stealing 线程池。execute 把 nb_jobs 个任务按连续区间平均分给各线程，
+// 线程做完自己的区间后从其他线程区间的尾部偷取一半，调用线程也作为其中一个线程参与执行。
+class ThreadPool {
+public:
+    typedef std::function<void(int32_t job, int32_t thread_index)> JobFunc;
+
+    // nb_threads 包含调用线程，<= 0 时使用 CPU 核数
+    explicit ThreadPool(int32_t nb_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int32_t size() const { return nb_threads_; }
+
+    // 阻塞直到全部任务完成；同一时刻只能有一个线程调用
+    void execute(int32_t nb_jobs, const JobFunc &func);
+
+private:
+    struct JobRange {
+        std::atomic<uint64_t> range; // 高 32 位为 begin，低 32 位为 end
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    void worker_loop(int32_t thread_index);
+    void run_jobs(int32_t thread_index);
+    bool pop_job(int32_t thread_index, int32_t &job);
+    bool steal_job(int32_t thread_index, int32_t &job);
+
+    int32_t nb_threads_;
+    std::vector<std::thread> workers_;
+    std::vector<JobRange> ranges_;
+
+    std::mutex mutex_;
+    std::condition_variable start_cond_;
+    std::condition_variable done_cond_;
+    uint64_t generation_ = 0;
+    int32_t finished_workers_ = 0;
+    bool stopping_ = false;
+    const JobFunc *func_ = nullptr;
+};
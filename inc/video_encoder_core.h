@@ -8,4 +8,7 @@ void destroy_video_encoder();
 
 int32_t encoding(int32_t frame_cnt);
 
+struct AVFrame;
+int32_t encode_video_frame(const AVFrame *input_frame);
+
 #endif //__VIDEO_ENCODER_CORE_H
\ No newline at end of file
@@ -1,8 +1,44 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 
+struct AVFrame;
+class VideoStage;
 
-int32_t init_video_filter(int32_t width, int32_t height, const char* filter_describe);
+// 输出帧回调，帧在回调返回后被 unref，需要保留时自行 av_frame_ref
+using VideoFilterOutputCallback = std::function<int32_t(AVFrame *frame)>;
+
+// 在 init_video_filter 之前注册输出，name 对应滤镜描述中的输出标签，例如
+// "split=2[a][b];[a]scale=640:-2[preview];[b]scale=160:-2[thumb]"。
+// 一次滤镜图处理即可同时得到所有输出。不注册时使用单个 "out" 输出并写入输出文件。
+int32_t add_video_filter_output(const char *name, const VideoFilterOutputCallback &callback);
+
+// 挂接原生处理阶段（见 video_native_stage.h），按添加顺序执行，所有权转交给滤镜模块。
+// output 为 nullptr 时在送入滤镜图之前执行，必须在 init_video_filter 之前添加；否则在该输出的回调之前执行。
+// 只用原生阶段时，滤镜描述可以写 "null"。
+int32_t add_video_filter_stage(VideoStage *stage, const char *output = nullptr);
+
+// nb_threads: 滤镜图的切片线程数，0 为自动；thread_type: "slice" 或 "none"；
+// use_thread_pool: 用自带的 work-stealing 线程池代替 libavfilter 内部线程，并按滤镜统计耗时；
+// reusable: 启用滤镜图缓存时，本次的滤镜图结束后是否归还到缓存
+int32_t init_video_filter(
+    int32_t width,
+    int32_t height,
+    const char *filter_describe,
+    int32_t nb_threads = 0,
+    const char *thread_type = "slice",
+    bool use_thread_pool = false,
+    bool reusable = true);
+// 处理 frame_cnt 帧后冲刷滤镜图，每次 init 之后只调用一次
 int32_t filter_video(int32_t frame_cnt);
+// 不重建滤镜图的情况下修改滤镜参数：send 立即生效，queue 在时间戳 >= ts(秒) 的帧上生效
+int32_t send_video_filter_command(const char *target, const char *cmd, const char *arg);
+int32_t queue_video_filter_command(const char *target, const char *cmd, const char *arg, double ts);
+// 启用后 destroy_video_filter 把滤镜图归还到 filter_graph_cache，后续相同配置的 init 直接复用。
+// 只有全部由无状态滤镜（scale、crop、drawbox 等，见 is_filter_graph_reusable）组成的滤镜图会被复用，
+// 其余的在结束时用 EOF 冲刷后释放。默认关闭
+void enable_video_filter_graph_cache(bool enable);
+// 输出滤镜图建立耗时（含缓存命中）与每帧处理耗时
+void print_video_filter_stats();
 void destroy_video_filter();
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+#include "frame_pool.h"
+
+// 不经过 libavfilter 的 YUV420P 原生处理阶段，省去滤镜图协商、格式转换和每级一次的帧拷贝。
+// 可以单独串联使用，也可以通过 add_video_filter_stage 挂在滤镜图之前或某个输出之后。
+class VideoStage {
+public:
+    virtual ~VideoStage() = default;
+
+    virtual const char *name() const = 0;
+
+    // 根据输入尺寸推算输出尺寸，用于在建图前确定 buffersrc 的参数
+    virtual void output_size(int32_t &width, int32_t &height) const = 0;
+
+    // 为 true 时直接改写 frame 的像素，调用者需保证缓冲区没有被其他使用者共享
+    virtual bool in_place() const { return false; }
+
+    // frame 既是输入也是输出，可能被替换为另一块缓冲区的引用
+    virtual int32_t process(AVFrame *frame) = 0;
+};
+
+// 只调整数据指针，不拷贝像素。x、y 必须为偶数
+class CropStage : public VideoStage {
+public:
+    CropStage(int32_t x, int32_t y, int32_t width, int32_t height);
+    const char *name() const override { return "crop"; }
+    void output_size(int32_t &width, int32_t &height) const override;
+    int32_t process(AVFrame *frame) override;
+
+private:
+    int32_t x_, y_, width_, height_;
+};
+
+// 把输入放到 width x height 画布的 (x, y) 处，其余区域填充 YUV 颜色
+class PadStage : public VideoStage {
+public:
+    PadStage(
+        int32_t x,
+        int32_t y,
+        int32_t width,
+        int32_t height,
+        uint8_t y_color = 16,
+        uint8_t u_color = 128,
+        uint8_t v_color = 128);
+    const char *name() const override { return "pad"; }
+    void output_size(int32_t &width, int32_t &height) const override;
+    int32_t process(AVFrame *frame) override;
+
+private:
+    int32_t x_, y_, width_, height_;
+    uint8_t color_[3];
+    FramePool pool_;
+    int32_t pool_width_ = 0, pool_height_ = 0;
+};
+
+class HFlipStage : public VideoStage {
+public:
+    const char *name() const override { return "hflip"; }
+    void output_size(int32_t &, int32_t &) const override {}
+    int32_t process(AVFrame *frame) override;
+
+private:
+    FramePool pool_;
+    int32_t pool_width_ = 0, pool_height_ = 0;
+};
+
+// 把 YUVA420P 图像按其 alpha 原地叠加到输入的 (x, y) 处，超出画面的部分被裁掉
+class OverlayStage : public VideoStage {
+public:
+    OverlayStage(int32_t x, int32_t y);
+    ~OverlayStage() override;
+    const char *name() const override { return "overlay"; }
+    void output_size(int32_t &, int32_t &) const override {}
+    bool in_place() const override { return true; }
+    int32_t process(AVFrame *frame) override;
+
+    int32_t set_image(const AVFrame *image);
+
+private:
+    int32_t x_, y_;
+    AVFrame *image_ = nullptr;
+    // 色度平面的 alpha，由 2x2 亮度 alpha 求均值预先算好
+    uint8_t *chroma_alpha_ = nullptr;
+};
+
+// 按描述创建阶段，失败返回 nullptr：
+// "crop=w:h:x:y"、"pad=w:h:x:y"、"hflip"、"overlay=yuva420p_file:w:h:x:y"
+VideoStage *create_video_stage(const char *describe);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 绕过 libswscale 的专用转换内核：YUV420P<->NV12、YUV420P 整数倍(2x/4x)盒式下采样、
+// RGB24<->YUV420P(BT.709 有限范围)。NV12 交织与盒式下采样在 x86 上使用 SSE2/AVX2、ARM 上使用 NEON，
+// 其余平台为 C++ 实现；RGB24 转换在所有平台上都是标量实现。
+typedef int32_t (*scale_kernel_func)(const AVFrame *src, AVFrame *dst);
+
+struct ScaleKernel {
+    const char *name;
+    enum AVPixelFormat src_pix_fmt;
+    enum AVPixelFormat dst_pix_fmt;
+    int32_t factor; // 宽高的缩小倍数，1 表示只做格式转换
+    scale_kernel_func func;
+};
+
+// 查找与转换参数完全匹配的内核，没有匹配时返回 nullptr，调用者应回退到 libswscale。
+// 下采样内核只替代 fast_bilinear/bilinear/area 这类低阶算法。
+const ScaleKernel *find_scale_kernel(
+    int32_t src_width,
+    int32_t src_height,
+    enum AVPixelFormat src_pix_fmt,
+    int32_t dst_width,
+    int32_t dst_height,
+    enum AVPixelFormat dst_pix_fmt,
+    int32_t flags);
@@ -2,6 +2,21 @@
 
 #include <cstdint>
 
-int32_t init_video_swscale(char *src_size, char *src_fmt, char *dst_size, char *dst_fmt);
+struct AVFrame;
+
+// threads: libswscale 切片线程数，1 为单线程，0 为自动
+// algorithm: fast_bilinear/bilinear/bicubic/lanczos/area/spline 等缩放算法名
+int32_t init_video_swscale(
+    char *src_size,
+    char *src_fmt,
+    char *dst_size,
+    char *dst_fmt,
+    int32_t threads = 1,
+    const char *algorithm = "bilinear");
+// 将算法名映射为 SWS_* 标志，未知算法返回 -1
+int32_t get_sws_algorithm_flags(const char *algorithm);
+int32_t scale_video_frame(const AVFrame *src, AVFrame *dst);
+// 缩放到输出帧池中的对齐帧，dst 获得该帧的引用，可直接交给编码器或滤镜图，用完 av_frame_unref 即归还
+int32_t scale_to_pooled_frame(const AVFrame *src, AVFrame *dst);
 int32_t transform(int32_t frame_cnt);
 void destroy_video_swscale();
@@ -0,0 +1,202 @@
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/mem.h>
+#include <libavutil/samplefmt.h>
+}
+
+#include "audio_codec_common.h"
+
+// 大缓冲区减少读取次数；剩余数据低于阈值时补满
+#define AUDIO_INBUF_SIZE    262144
+#define AUDIO_REFILL_THRESH 65536
+
+const AVCodec *find_audio_codec(const char *codec_name, bool encoder) {
+    std::string name(codec_name);
+    for (size_t i = 0; i < name.size(); i++) { name[i] = (char)tolower((unsigned char)name[i]); }
+
+    const AVCodec *found =
+        encoder ? avcodec_find_encoder_by_name(name.c_str()) : avcodec_find_decoder_by_name(name.c_str());
+    if (!found) {
+        const AVCodecDescriptor *descriptor = avcodec_descriptor_get_by_name(name.c_str());
+        if (descriptor) {
+            found = encoder ? avcodec_find_encoder(descriptor->id) : avcodec_find_decoder(descriptor->id);
+        }
+    }
+    if (!found || found->type != AVMEDIA_TYPE_AUDIO) {
+        std::cerr << "Error: cannot find audio " << (encoder ? "encoder " : "decoder ") << name << std::endl;
+        return nullptr;
+    }
+    return found;
+}
+
+int32_t parse_audio_stream(
+    AVCodecParserContext *parser,
+    AVCodecContext *codec_ctx,
+    AVPacket *packet,
+    std::vector<uint8_t> &inbuf,
+    const AudioInputReadCallback &read_input,
+    const AudioPacketCallback &on_packet) {
+    // 末尾的填充区必须清零，解码器可能越过数据末尾读取
+    if (inbuf.size() < AUDIO_INBUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE) {
+        inbuf.assign(AUDIO_INBUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE, 0);
+    }
+    uint8_t *data = inbuf.data();
+    int32_t data_size = 0;
+    bool input_end = false;
+
+    while (true) {
+        if (data_size < AUDIO_REFILL_THRESH && !input_end) {
+            memmove(inbuf.data(), data, data_size);
+            data = inbuf.data();
+
+            int32_t read_size = read_input(data + data_size, AUDIO_INBUF_SIZE - data_size);
+            if (read_size < 0) {
+                std::cerr << "Error: cannot read audio input." << std::endl;
+                return -1;
+            }
+            input_end = read_size == 0;
+            data_size += read_size;
+            memset(data + data_size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+        }
+
+        // 输入结束后传入空数据，取出解析器中缓存的最后一帧
+        int32_t used = av_parser_parse2(
+            parser, codec_ctx, &packet->data, &packet->size, data_size ? data : nullptr, data_size, AV_NOPTS_VALUE,
+            AV_NOPTS_VALUE, 0);
+        if (used < 0) {
+            std::cerr << "Error: av_parser_parse2 failed." << std::endl;
+            return used;
+        }
+        data += used;
+        data_size -= used;
+
+        if (packet->size) {
+            int32_t result = on_packet(packet);
+            if (result < 0) { return result; }
+        } else if (input_end && data_size == 0) {
+            break;
+        }
+    }
+    return 0;
+}
+
+AudioFifoWriter::~AudioFifoWriter() {
+    uninit();
+}
+
+int32_t AudioFifoWriter::init(
+    AVAudioFifo *fifo,
+    const AVChannelLayout *ch_layout,
+    enum AVSampleFormat sample_fmt,
+    int32_t sample_rate) {
+    uninit();
+    if (av_channel_layout_copy(&out_ch_layout_, ch_layout) < 0) {
+        std::cerr << "Error: could not copy channel layout." << std::endl;
+        return -1;
+    }
+    fifo_ = fifo;
+    out_sample_fmt_ = sample_fmt;
+    out_sample_rate_ = sample_rate;
+    return 0;
+}
+
+void AudioFifoWriter::uninit() {
+    swr_free(&swr_ctx_);
+    if (!convert_planes_.empty()) { av_freep(&convert_planes_[0]); }
+    convert_planes_.clear();
+    convert_capacity_ = 0;
+    av_channel_layout_uninit(&in_ch_layout_);
+    av_channel_layout_uninit(&out_ch_layout_);
+    in_sample_fmt_ = out_sample_fmt_ = AV_SAMPLE_FMT_NONE;
+    in_sample_rate_ = out_sample_rate_ = 0;
+    fifo_ = nullptr;
+}
+
+int32_t AudioFifoWriter::reset() {
+    // 重新初始化会清空重采样器内部缓存的样本，参数保持不变
+    if (swr_ctx_ && swr_init(swr_ctx_) < 0) {
+        std::cerr << "Error: cannot reset SwrContext." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t AudioFifoWriter::set_input(
+    const AVChannelLayout *ch_layout,
+    enum AVSampleFormat sample_fmt,
+    int32_t sample_rate) {
+    if (sample_fmt == in_sample_fmt_ && sample_rate == in_sample_rate_
+        && !av_channel_layout_compare(ch_layout, &in_ch_layout_)) {
+        return 0;
+    }
+
+    // 输入参数中途变化时先取出旧上下文中的样本
+    if (swr_ctx_ && write(nullptr, 0) < 0) { return -1; }
+    swr_free(&swr_ctx_);
+    if (av_channel_layout_copy(&in_ch_layout_, ch_layout) < 0) { return -1; }
+    in_sample_fmt_ = sample_fmt;
+    in_sample_rate_ = sample_rate;
+
+    if (sample_fmt == out_sample_fmt_ && sample_rate == out_sample_rate_
+        && !av_channel_layout_compare(ch_layout, &out_ch_layout_)) {
+        return 0;
+    }
+    if (swr_alloc_set_opts2(
+            &swr_ctx_, &out_ch_layout_, out_sample_fmt_, out_sample_rate_, ch_layout, sample_fmt, sample_rate, 0,
+            nullptr)
+            < 0
+        || swr_init(swr_ctx_) < 0) {
+        std::cerr << "Error: cannot initialize SwrContext." << std::endl;
+        swr_free(&swr_ctx_);
+        in_sample_fmt_ = AV_SAMPLE_FMT_NONE;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t AudioFifoWriter::write(const uint8_t *const *data, int32_t nb_samples) {
+    if (!swr_ctx_) {
+        if (data && av_audio_fifo_write(fifo_, (void **)data, nb_samples) < nb_samples) {
+            std::cerr << "Error: could not write to audio fifo." << std::endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    if (!data) { nb_samples = 0; }
+    int32_t out_samples = swr_get_out_samples(swr_ctx_, nb_samples);
+    if (out_samples > convert_capacity_) {
+        int32_t channels = out_ch_layout_.nb_channels;
+        if (!convert_planes_.empty()) { av_freep(&convert_planes_[0]); }
+        convert_planes_.assign(channels, nullptr);
+        if (av_samples_alloc(convert_planes_.data(), nullptr, channels, out_samples, out_sample_fmt_, 0) < 0) {
+            std::cerr << "Error: could not allocate convert buffer." << std::endl;
+            convert_planes_.clear();
+            convert_capacity_ = 0;
+            return -1;
+        }
+        convert_capacity_ = out_samples;
+    }
+
+    int32_t converted =
+        swr_convert(swr_ctx_, convert_planes_.data(), convert_capacity_, (const uint8_t **)data, nb_samples);
+    if (converted < 0) {
+        std::cerr << "Error: swr_convert failed." << std::endl;
+        return -1;
+    }
+    if (av_audio_fifo_write(fifo_, (void **)convert_planes_.data(), converted) < converted) {
+        std::cerr << "Error: could not write to audio fifo." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t AudioFifoWriter::write_frame(const AVFrame *frame) {
+    if (set_input(&frame->ch_layout, (enum AVSampleFormat)frame->format, frame->sample_rate) < 0) { return -1; }
+    return write(frame->extended_data, frame->nb_samples);
+}
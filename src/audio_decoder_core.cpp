@@ -2,45 +2,54 @@
 #include <cstdint>
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+#include <libswresample/swresample.h>
 }
 
 #include <iostream>
+#include <string>
+#include <vector>
 
+#include "audio_codec_common.h"
 #include "audio_decoder_core.h"
 #include "io_data.h"
 
-#define AUDIO_INBUF_SIZE    20480
-#define AUDIO_REFILL_THRESH 4096
-
 static const AVCodec *codec = nullptr;
 static AVCodecContext *codec_ctx = nullptr;
 static AVCodecParserContext *parser = nullptr;
 
 static AVFrame *frame = nullptr;
 static AVPacket *packet = nullptr;
-static enum AVCodecID codec_id;
-
-int32_t init_audio_decoder(const char *audio_codec) {
-    if (strcasecmp(audio_codec, "MP3") == 0) {
-        codec_id = AV_CODEC_ID_MP3;
-        std::cout << "Select codec id: MP3" << std::endl;
-    } else if (strcasecmp(audio_codec, "AAC") == 0) {
-        codec_id = AV_CODEC_ID_AAC;
-        std::cout << "Select codec id: AAC" << std::endl;
-    } else {
-        std::cerr << "Error invalid audio format." << std::endl;
-        return -1;
-    }
-
-    codec = avcodec_find_decoder(codec_id);
-    if (!codec) {
-        std::cerr << "Error: cannot find codec." << std::endl;
-        return -1;
-    }
 
+// 目标输出格式，未指定的部分沿用解码器的输出。解码器能直接输出目标格式时不做转换，
+// 否则在第一帧到来（或输入参数变化）时建立 SwrContext 逐帧转换，省去单独的重采样步骤
+static AVChannelLayout target_ch_layout;
+static int32_t target_sample_rate = 0;
+static enum AVSampleFormat target_sample_fmt = AV_SAMPLE_FMT_NONE;
+
+static SwrContext *swr_ctx = nullptr;
+static AVFrame *converted_frame = nullptr;
+static AVChannelLayout swr_in_ch_layout, swr_out_ch_layout;
+static int32_t swr_in_sample_rate = 0, swr_out_sample_rate = 0;
+static enum AVSampleFormat swr_in_sample_fmt = AV_SAMPLE_FMT_NONE, swr_out_sample_fmt = AV_SAMPLE_FMT_NONE;
+
+// 实际写出的格式，用于最后打印播放命令
+static enum AVSampleFormat output_sample_fmt = AV_SAMPLE_FMT_NONE;
+static int32_t output_channels = 0, output_sample_rate = 0;
+
+int32_t init_audio_decoder(
+    const char *audio_codec,
+    const char *ch_layout,
+    int32_t sample_rate,
+    const char *sample_fmt) {
+    codec = find_audio_codec(audio_codec, false);
+    if (!codec) { return -1; }
+    std::cout << "Select decoder: " << codec->name << std::endl;
+
+    // 裸流需要解析器切分压缩帧；Opus/Vorbis 通常封装在 Ogg 中，应先用解封装模块读出数据包
     parser = av_parser_init(codec->id);
     if (!parser) {
-        std::cerr << "Error: cannot find parser." << std::endl;
+        std::cerr << "Error: no parser for " << codec->name << ", demux the container first." << std::endl;
         return -1;
     }
 
@@ -50,6 +59,23 @@ int32_t init_audio_decoder(const char *audio_codec) {
         return -1;
     }
 
+    if (ch_layout && av_channel_layout_from_string(&target_ch_layout, ch_layout) < 0) {
+        std::cerr << "Error: invalid channel layout " << std::string(ch_layout) << std::endl;
+        return -1;
+    }
+    if (sample_fmt && (target_sample_fmt = av_get_sample_fmt(sample_fmt)) == AV_SAMPLE_FMT_NONE) {
+        std::cerr << "Error: invalid sample format " << std::string(sample_fmt) << std::endl;
+        return -1;
+    }
+    target_sample_rate = sample_rate;
+
+    // 解码器自带的能力优先：request_sample_fmt 对支持多种输出格式的解码器生效，
+    // AC-3/E-AC-3/DTS 等解码器的 downmix 选项在解码时直接下混；不支持的选项被忽略
+    if (target_sample_fmt != AV_SAMPLE_FMT_NONE) { codec_ctx->request_sample_fmt = target_sample_fmt; }
+    if (ch_layout && av_opt_set(codec_ctx, "downmix", ch_layout, AV_OPT_SEARCH_CHILDREN) == 0) {
+        std::cout << "Decoder downmix to " << std::string(ch_layout) << std::endl;
+    }
+
     int32_t result = avcodec_open2(codec_ctx, codec, nullptr);
     if (result < 0) {
         std::cerr << "Error: cannot open codec." << std::endl;
@@ -57,7 +83,8 @@ int32_t init_audio_decoder(const char *audio_codec) {
     }
 
     frame = av_frame_alloc();
-    if (!frame) {
+    converted_frame = av_frame_alloc();
+    if (!frame || !converted_frame) {
         std::cerr << "Error: cannot allocate frame." << std::endl;
         return -1;
     }
@@ -72,12 +99,90 @@ int32_t init_audio_decoder(const char *audio_codec) {
 }
 
 
+static int32_t write_output_frame(AVFrame *output) {
+    output_sample_fmt = (enum AVSampleFormat)output->format;
+    output_channels = output->ch_layout.nb_channels;
+    output_sample_rate = output->sample_rate;
+    return write_samples_to_pcm2(output, output_sample_fmt, output_channels);
+}
+
+// input 为 nullptr 时取出 SwrContext 中缓存的延迟样本
+static int32_t convert_and_write(const AVFrame *input) {
+    if (!swr_ctx && !input) { return 0; }
+
+    converted_frame->sample_rate = swr_out_sample_rate;
+    converted_frame->format = swr_out_sample_fmt;
+    if (av_channel_layout_copy(&converted_frame->ch_layout, &swr_out_ch_layout) < 0) { return -1; }
+
+    int32_t result = swr_convert_frame(swr_ctx, converted_frame, input);
+    if (result < 0) {
+        std::cerr << "Error: swr_convert_frame failed." << std::endl;
+        av_frame_unref(converted_frame);
+        return -1;
+    }
+    if (converted_frame->nb_samples > 0) { result = write_output_frame(converted_frame); }
+    av_frame_unref(converted_frame);
+    return result;
+}
+
+static int32_t build_swr_context(
+    const AVFrame *input,
+    const AVChannelLayout *out_layout,
+    int32_t out_rate,
+    enum AVSampleFormat out_fmt) {
+    // 输入参数中途变化时先取出旧上下文中的样本
+    if (swr_ctx && convert_and_write(nullptr) < 0) { return -1; }
+    swr_free(&swr_ctx);
+
+    int32_t result = swr_alloc_set_opts2(
+        &swr_ctx, out_layout, out_fmt, out_rate, &input->ch_layout, (enum AVSampleFormat)input->format,
+        input->sample_rate, 0, nullptr);
+    if (result < 0 || swr_init(swr_ctx) < 0) {
+        std::cerr << "Error: cannot initialize SwrContext." << std::endl;
+        swr_free(&swr_ctx);
+        return -1;
+    }
+
+    if (av_channel_layout_copy(&swr_in_ch_layout, &input->ch_layout) < 0
+        || av_channel_layout_copy(&swr_out_ch_layout, out_layout) < 0) {
+        return -1;
+    }
+    swr_in_sample_rate = input->sample_rate;
+    swr_in_sample_fmt = (enum AVSampleFormat)input->format;
+    swr_out_sample_rate = out_rate;
+    swr_out_sample_fmt = out_fmt;
+    std::cout << "Convert decoded audio: " << input->sample_rate << "Hz " << input->ch_layout.nb_channels << "ch "
+              << av_get_sample_fmt_name(swr_in_sample_fmt) << " -> " << out_rate << "Hz " << out_layout->nb_channels
+              << "ch " << av_get_sample_fmt_name(out_fmt) << std::endl;
+    return 0;
+}
+
+static int32_t process_decoded_frame(AVFrame *input) {
+    const AVChannelLayout *out_layout = target_ch_layout.nb_channels ? &target_ch_layout : &input->ch_layout;
+    int32_t out_rate = target_sample_rate ? target_sample_rate : input->sample_rate;
+    enum AVSampleFormat out_fmt =
+        target_sample_fmt != AV_SAMPLE_FMT_NONE ? target_sample_fmt : (enum AVSampleFormat)input->format;
+
+    bool input_changed = !swr_ctx || input->sample_rate != swr_in_sample_rate || input->format != swr_in_sample_fmt
+                         || av_channel_layout_compare(&input->ch_layout, &swr_in_ch_layout);
+    if (input_changed) {
+        // 解码器已直接输出目标格式
+        if (!swr_ctx && input->format == out_fmt && input->sample_rate == out_rate
+            && !av_channel_layout_compare(&input->ch_layout, out_layout)) {
+            return write_output_frame(input);
+        }
+        if (build_swr_context(input, out_layout, out_rate, out_fmt) < 0) { return -1; }
+    }
+    return convert_and_write(input);
+}
+
+// 解码错误返回 FFmpeg 的错误码，调用者据此跳过损坏的数据包 (AVERROR_INVALIDDATA)；转换或写入失败返回 -1
 static int32_t decode_packet(bool flushing) {
     int32_t result = 0;
-    result = avcodec_send_packet(codec_ctx, packet);
+    result = avcodec_send_packet(codec_ctx, flushing ? nullptr : packet);
     if (result < 0) {
         std::cerr << "Error: cannot send packet. result : " << result << std::endl;
-        return -1;
+        return result;
     }
 
     while (result >= 0) {
@@ -87,14 +192,14 @@ static int32_t decode_packet(bool flushing) {
         }
         if (result < 0) {
             std::cerr << "Error: cannot receive frame. result : " << result << std::endl;
-            return -1;
+            return result;
         }
 
         if (flushing) {
             std::cout << "Flushing audio data." << std::endl;
         }
 
-        write_samples_to_pcm(frame, codec_ctx);
+        if (process_decoded_frame(frame) < 0) { return -1; }
         std::cout << "frame->nb_samples:" << frame->nb_samples
                 << ", frame->channels:" << frame->ch_layout.nb_channels << std::endl;
     }
@@ -135,68 +240,44 @@ static int get_format_from_sample_fmt(const char** fmt, enum AVSampleFormat samp
 }
 
 
-static int32_t get_audio_format(AVCodecContext *codec_ctx) {
+// 输出文件中的样本总是交错存放的
+static int32_t get_audio_format(enum AVSampleFormat sample_fmt, int n_channels, int sample_rate) {
     int ret = 0;
     const char *fmt = nullptr;
-    enum AVSampleFormat sample_fmt = codec_ctx->sample_fmt;
 
-    if (av_sample_fmt_is_planar(sample_fmt)) {
-        const char *fmt_name = av_get_sample_fmt_name(sample_fmt);
-        std::cout << "Warning: the sample format the decoder produced is planar "
-            << std::string(fmt_name)
-            << ", This example will output the first channel only."
-            << std::endl;
-        sample_fmt = av_get_packed_sample_fmt(sample_fmt);
-    }
-
-    int n_channels = codec_ctx->ch_layout.nb_channels;
-    ret = get_format_from_sample_fmt(&fmt, sample_fmt);
+    ret = get_format_from_sample_fmt(&fmt, av_get_packed_sample_fmt(sample_fmt));
     if (ret < 0) {
         return -1;
     }
 
     std::cout << "Play command: ffpay -f " << std::string(fmt) << " -ac "
-            << n_channels << " -ar " << codec_ctx->sample_rate << " output.pcm"
+            << n_channels << " -ar " << sample_rate << " output.pcm"
             << std::endl;
 
     return 0;
 }
 
 
-int32_t audio_decoding() {
-    uint8_t inbuf[AUDIO_INBUF_SIZE + AV_INPUT_BUFFER_PADDING_SIZE] = {0};
-    uint8_t *data = nullptr;
-    int32_t result = 0;
-    int32_t data_size = 0;
-
-    while (!end_of_input_file()) {
-        result = read_data_to_buf(inbuf, AUDIO_INBUF_SIZE, data_size);
-        if (result < 0) {
-            std::cerr << "Error: cannot read_data_to_buf." << std::endl;
-            return -1;
-        }
-
-        data = inbuf;
-        while (data_size > 0) {
-            result = av_parser_parse2(parser, codec_ctx, &packet->data, &packet->size, data,
-                                data_size, AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
-            if (result < 0) {
-                std::cerr << "Error: av_parser_parse2 failed." << std::endl;
-                return -1;
-            }
-
-            data += result;
-            data_size -= result;
-            if (packet->size) {
-                std::cout << "Parsed packet size:" << packet->size << std::endl;
-                decode_packet(false);
-            }
-        }
-    }
-
-    decode_packet(true);
+static int32_t read_input(uint8_t *buf, int32_t size) {
+    int32_t read_size = 0;
+    if (end_of_input_file()) { return 0; }
+    if (read_data_to_buf(buf, size, read_size) < 0) { return end_of_input_file() ? 0 : -1; }
+    return read_size;
+}
 
-    get_audio_format(codec_ctx);
+int32_t audio_decoding() {
+    std::vector<uint8_t> inbuf;
+    // 损坏的数据包跳过，不中断整个文件；其他解码错误以及转换、写入失败都要返回，否则输出被截断却报告成功
+    int32_t result = parse_audio_stream(parser, codec_ctx, packet, inbuf, read_input, [](AVPacket *) {
+        int32_t decoded = decode_packet(false);
+        return decoded == AVERROR_INVALIDDATA ? 0 : decoded;
+    });
+    if (result < 0) { return -1; }
+
+    result = decode_packet(true);
+    if ((result < 0 && result != AVERROR_INVALIDDATA) || convert_and_write(nullptr) < 0) { return -1; }
+
+    if (output_channels > 0) { get_audio_format(output_sample_fmt, output_channels, output_sample_rate); }
     return 0;
 }
 
@@ -206,5 +287,13 @@ void destroy_audio_decoder() {
     avcodec_free_context(&codec_ctx);
     av_frame_free(&frame);
     av_packet_free(&packet);
+    swr_free(&swr_ctx);
+    av_frame_free(&converted_frame);
+    av_channel_layout_uninit(&target_ch_layout);
+    av_channel_layout_uninit(&swr_in_ch_layout);
+    av_channel_layout_uninit(&swr_out_ch_layout);
+    target_sample_rate = 0;
+    target_sample_fmt = AV_SAMPLE_FMT_NONE;
+    output_channels = 0;
 }
 
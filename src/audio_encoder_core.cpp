@@ -1,15 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
+#include <libavutil/audio_fifo.h>
 #include <libavutil/channel_layout.h>
 #include <libavutil/common.h>
 #include <libavutil/frame.h>
 #include <libavutil/samplefmt.h>
 }
 
+#include "audio_codec_common.h"
 #include "io_data.h"
 #include "audio_encoder_core.h"
 
@@ -20,8 +24,65 @@ static AVPacket *pkt = nullptr;
 
 static enum AVCodecID audio_codec_id;
 
+// 从文件读取时每次读取的样本数，与编码器帧长无关
+#define AUDIO_READ_CHUNK 4096
+
+// 任意长度的输入样本先进入 FIFO，再按编码器帧长切分；FIFO 在第一次扩容后不再分配内存
+static AVAudioFifo *fifo = nullptr;
+static int64_t next_pts = 0;
+static std::vector<uint8_t> chunk_buffer;  // 文件读取缓冲，保存不足一个样本的剩余字节
+static size_t chunk_buffered = 0;
+
+// 输入文件中交错存放的 PCM 格式；与编码器参数不同时由 SwrContext 一步完成格式、采样率和声道转换
+static enum AVSampleFormat input_sample_fmt = AV_SAMPLE_FMT_NONE;
+static int32_t input_sample_rate = 0;
+static AVChannelLayout input_ch_layout;
+static AudioFifoWriter fifo_writer;
+
+
+// 编码器支持输入的采样率时直接使用，否则选择最接近的
+static int32_t select_sample_rate(const AVCodec *codec, int32_t sample_rate) {
+    if (!codec->supported_samplerates) { return sample_rate; }
+    int32_t best = codec->supported_samplerates[0];
+    for (const int *rate = codec->supported_samplerates; *rate; rate++) {
+        if (abs(*rate - sample_rate) < abs(best - sample_rate)) { best = *rate; }
+    }
+    return best;
+}
+
+// 编码器支持输入的采样格式时直接使用，否则使用编码器的首选格式
+static enum AVSampleFormat select_sample_fmt(const AVCodec *codec, enum AVSampleFormat sample_fmt) {
+    if (!codec->sample_fmts) { return sample_fmt; }
+    for (const enum AVSampleFormat *fmt = codec->sample_fmts; *fmt != AV_SAMPLE_FMT_NONE; fmt++) {
+        if (*fmt == sample_fmt) { return sample_fmt; }
+    }
+    return codec->sample_fmts[0];
+}
+
+static int32_t select_ch_layout(const AVCodec *codec, const AVChannelLayout *input, AVChannelLayout *output) {
+    if (!codec->ch_layouts) { return av_channel_layout_copy(output, input); }
+    for (const AVChannelLayout *layout = codec->ch_layouts; layout->nb_channels; layout++) {
+        if (!av_channel_layout_compare(layout, input)) { return av_channel_layout_copy(output, input); }
+    }
+    AVChannelLayout stereo = AV_CHANNEL_LAYOUT_STEREO;
+    return av_channel_layout_copy(output, &stereo);
+}
+
+int32_t init_audio_encoder(
+    const char *codec_name,
+    const char *sample_fmt,
+    int32_t sample_rate,
+    const char *ch_layout) {
+    // 文件中的样本总是交错的，平面格式的名字按对应的交错格式处理
+    input_sample_fmt = av_get_packed_sample_fmt(av_get_sample_fmt(sample_fmt));
+    input_sample_rate = sample_rate;
+    if (input_sample_fmt == AV_SAMPLE_FMT_NONE || input_sample_rate <= 0
+        || av_channel_layout_from_string(&input_ch_layout, ch_layout) < 0) {
+        std::cerr << "Error: invalid input format " << std::string(sample_fmt) << " " << sample_rate << " "
+                  << std::string(ch_layout) << std::endl;
+        return -1;
+    }
 
-int32_t init_audio_encoder(const char *codec_name) {
     if (strcasecmp(codec_name, "MP3") == 0) {
         audio_codec_id = AV_CODEC_ID_MP3;
         std::cout << "Select codec id: MP3" << std::endl;
@@ -45,13 +106,18 @@ int32_t init_audio_encoder(const char *codec_name) {
         return -1;
     }
 
+    // 尽量让编码器直接接受输入参数，省去转换
     codec_ctx->bit_rate = 128000;
-    codec_ctx->sample_fmt = AV_SAMPLE_FMT_FLTP;  // fltp 采样格式
-    codec_ctx->sample_rate = 44100;   // 44.1kHz
-    codec_ctx->ch_layout = AV_CHANNEL_LAYOUT_STEREO;  // 声道数立体声双声道
-    codec_ctx->ch_layout.nb_channels = 2;
+    codec_ctx->sample_fmt = select_sample_fmt(codec, input_sample_fmt);
+    codec_ctx->sample_rate = select_sample_rate(codec, input_sample_rate);
+    codec_ctx->time_base = (AVRational){1, codec_ctx->sample_rate};
+    int32_t result = select_ch_layout(codec, &input_ch_layout, &codec_ctx->ch_layout);
+    if (result < 0) {
+        std::cerr << "Error: could not select channel layout." << std::endl;
+        return -1;
+    }
 
-    int32_t result = avcodec_open2(codec_ctx, codec, nullptr);
+    result = avcodec_open2(codec_ctx, codec, nullptr);
     if (result < 0) {
         std::cerr << "Error: could not open codec." << std::endl;
         return -1;
@@ -78,6 +144,25 @@ int32_t init_audio_encoder(const char *codec_name) {
         return -1;
     }
 
+    fifo = av_audio_fifo_alloc(
+        codec_ctx->sample_fmt, codec_ctx->ch_layout.nb_channels, codec_ctx->frame_size + AUDIO_READ_CHUNK);
+    if (!fifo) {
+        std::cerr << "Error: could not allocate audio fifo." << std::endl;
+        return -1;
+    }
+    chunk_buffer.resize(
+        (size_t)AUDIO_READ_CHUNK * input_ch_layout.nb_channels * av_get_bytes_per_sample(input_sample_fmt));
+    chunk_buffered = 0;
+    next_pts = 0;
+
+    if (fifo_writer.init(fifo, &codec_ctx->ch_layout, codec_ctx->sample_fmt, codec_ctx->sample_rate) < 0
+        || fifo_writer.set_input(&input_ch_layout, input_sample_fmt, input_sample_rate) < 0) {
+        return -1;
+    }
+    std::cout << "Encoder input: " << av_get_sample_fmt_name(codec_ctx->sample_fmt) << " " << codec_ctx->sample_rate
+              << "Hz " << codec_ctx->ch_layout.nb_channels << "ch" << (fifo_writer.converting() ? " (converted)" : "")
+              << std::endl;
+
     return 0;
 }
 
@@ -88,7 +173,7 @@ static int32_t encode_frame(bool flushing) {
     result = avcodec_send_frame(codec_ctx, flushing ? nullptr : frame);
     if (result < 0) {
         std::cerr << "Error: could not avcodec_send_frame." << std::endl;
-        return -result;
+        return result;
     }
 
     while (result >= 0) {
@@ -107,33 +192,104 @@ static int32_t encode_frame(bool flushing) {
 }
 
 
+// 从 FIFO 取出 nb_samples 个样本编码，不足时用静音补齐到 pad_to
+static int32_t encode_from_fifo(int32_t nb_samples, int32_t pad_to) {
+    // 编码器可能仍持有上一帧的引用
+    int32_t result = av_frame_make_writable(frame);
+    if (result < 0) { return result; }
+
+    if (av_audio_fifo_read(fifo, (void **)frame->data, nb_samples) != nb_samples) {
+        std::cerr << "Error: could not read from audio fifo." << std::endl;
+        return -1;
+    }
+    if (pad_to > nb_samples) {
+        av_samples_set_silence(
+            frame->data, nb_samples, pad_to - nb_samples, codec_ctx->ch_layout.nb_channels, codec_ctx->sample_fmt);
+        nb_samples = pad_to;
+    }
+
+    frame->nb_samples = nb_samples;
+    frame->pts = next_pts;
+    next_pts += nb_samples;
+    result = encode_frame(false);
+    frame->nb_samples = codec_ctx->frame_size;
+    return result;
+}
+
+// 转换到编码器格式后送入 FIFO；data 为 nullptr 时取出重采样器中的延迟样本
+int32_t send_audio_samples(const uint8_t *const *data, int32_t nb_samples) {
+    if (fifo_writer.write(data, nb_samples) < 0) { return -1; }
+
+    while (av_audio_fifo_size(fifo) >= codec_ctx->frame_size) {
+        int32_t result = encode_from_fifo(codec_ctx->frame_size, 0);
+        if (result < 0) { return result; }
+    }
+    return 0;
+}
+
+int32_t flush_audio_encoder() {
+    if (send_audio_samples(nullptr, 0) < 0) { return -1; }
+
+    int32_t remaining = av_audio_fifo_size(fifo);
+    if (remaining > 0) {
+        // 支持短尾帧的编码器直接送入，否则补静音到完整帧长
+        bool small_last_frame =
+            codec->capabilities & (AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_VARIABLE_FRAME_SIZE);
+        int32_t result = encode_from_fifo(remaining, small_last_frame ? 0 : codec_ctx->frame_size);
+        if (result < 0) { return result; }
+    }
+
+    int32_t result = encode_frame(true);
+    if (result < 0) {
+        std::cerr << "Error: flushing failed." << std::endl;
+        return result;
+    }
+    return 0;
+}
+
+// 文件中的样本是交错存放的，读到多少处理多少，最后一次读取不足一帧也不会混入旧数据
 int32_t audio_encoding() {
     int32_t result = 0;
+    int32_t frame_bytes = av_get_bytes_per_sample(input_sample_fmt) * input_ch_layout.nb_channels;
+
     while (!end_of_input_file()) {
-        result = read_pcm_to_frame(frame, codec_ctx);
-        if (result < 0) {
-            std::cerr << "Error: read_pcm_to_frame failed." << std::endl;
-            return result;
+        int32_t read_size = 0;
+        if (read_data_to_buf(
+                chunk_buffer.data() + chunk_buffered, (int32_t)(chunk_buffer.size() - chunk_buffered), read_size)
+            < 0) {
+            if (end_of_input_file()) { break; }
+            std::cerr << "Error: read pcm data failed." << std::endl;
+            return -1;
         }
+        chunk_buffered += read_size;
 
-        result = encode_frame(false);
+        int32_t nb_samples = (int32_t)(chunk_buffered / frame_bytes);
+        const uint8_t *samples = chunk_buffer.data();
+        result = send_audio_samples(&samples, nb_samples);
         if (result < 0) {
             std::cerr << "Error: encode_frame failed." << std::endl;
             return result;
         }
-    }
 
-    result = encode_frame(true);
-    if (result < 0) {
-        std::cerr << "Error: flushing failed." << std::endl;
-        return result;
+        // 不足一个样本的尾部字节留到下一次读取
+        size_t used = (size_t)nb_samples * frame_bytes;
+        memmove(chunk_buffer.data(), chunk_buffer.data() + used, chunk_buffered - used);
+        chunk_buffered -= used;
     }
 
-    return 0;
+    return flush_audio_encoder();
 }
 
 
 void destroy_audio_encoder() {
+    if (fifo) {
+        av_audio_fifo_free(fifo);
+        fifo = nullptr;
+    }
+    fifo_writer.uninit();
+    av_channel_layout_uninit(&input_ch_layout);
+    chunk_buffer.clear();
+    chunk_buffered = 0;
     av_frame_free(&frame);
     av_packet_free(&pkt);
     avcodec_free_context(&codec_ctx);
@@ -1,7 +1,9 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <chrono>
 #include <iostream>
+#include <vector>
 
 extern "C" {
 #include <libavfilter/buffersink.h>
@@ -17,157 +19,139 @@ extern "C" {
 }
 
 #include "audio_filter_core.h"
+#include "frame_pool.h"
 #include "io_data.h"
 
 #define INPUT_SAMPLERATE     44100
 #define INPUT_FORMAT         AV_SAMPLE_FMT_FLTP
 #define INPUT_CHANNEL_LAYOUT AV_CH_LAYOUT_STEREO
-#define FRAME_SIZE           4096
+#define INPUT_CHANNELS       2
+#define INPUT_POOL_DEPTH     4
 
 static AVFilterGraph *filter_graph;
 static AVFilterContext *abuffersrc_ctx;
-static AVFilterContext *volume_ctx;
-static AVFilterContext *aformat_ctx;
 static AVFilterContext *abuffersink_ctx;
 
 static AVFrame *input_frame = nullptr, *output_frame = nullptr;
+static FramePool input_pool; // 滤镜图释放输入帧后缓冲区回到池中，长时间运行内存不增长
+static int32_t frame_size = 0;
+static std::vector<uint8_t> read_buffer; // 交错存放的输入样本，保存不足一个样本的剩余字节
+static size_t read_buffered = 0;
+static int64_t next_pts = 0; // 时间基为 1/INPUT_SAMPLERATE，按时间戳排队的命令依赖它
 
-int32_t init_audio_filter(char *volume_factor) {
-    int32_t result = 0;
-    char ch_layout[64];
-    char options_str[1024];
-    AVDictionary *options_dict = NULL;
-
-    /* 创建滤镜图 */
-    filter_graph = avfilter_graph_alloc();
-    if (!filter_graph) {
-        std::cout << "Failed Unable to create filter graph." << std::endl;
-        return AVERROR(ENOMEM);
-    }
+static AudioFilterOutputCallback output_callback;
 
-    /* 创建abuffer滤镜 */
-    const AVFilter *abuffer = avfilter_get_by_name("abuffer");
-    if (!abuffer) {
-        std::cout << "Failed Could not find the abuffer filter." << std::endl;
-        return AVERROR_FILTER_NOT_FOUND;
-    }
+static int64_t input_samples = 0, output_samples = 0;
+static int64_t filter_time_us = 0;
 
-    abuffersrc_ctx = avfilter_graph_alloc_filter(filter_graph, abuffer, "src");
-    if (!abuffersrc_ctx) {
-        std::cout << "Failed Could not allocate the abuffer instance." << std::endl;
-        return AVERROR(ENOMEM);
-    }
+void set_audio_filter_output(const AudioFilterOutputCallback &callback) {
+    output_callback = callback;
+}
 
-    const AVChannelLayout ch_layout_in = AV_CHANNEL_LAYOUT_STEREO;
-    av_channel_layout_describe(&ch_layout_in, ch_layout, sizeof(ch_layout));
-    // av_get_channel_layout_string(ch_layout, sizeof(ch_layout), 0, INPUT_CHANNEL_LAYOUT);
-    av_opt_set(abuffersrc_ctx, "channel_layout", ch_layout, AV_OPT_SEARCH_CHILDREN);
-    av_opt_set(abuffersrc_ctx, "sample_fmt", av_get_sample_fmt_name(INPUT_FORMAT), AV_OPT_SEARCH_CHILDREN);
-    av_opt_set_q(abuffersrc_ctx, "time_base", (AVRational){1, INPUT_SAMPLERATE}, AV_OPT_SEARCH_CHILDREN);
-    av_opt_set_int(abuffersrc_ctx, "sample_rate", INPUT_SAMPLERATE, AV_OPT_SEARCH_CHILDREN);
+int32_t init_audio_filter(const char *filter_describe, int32_t samples_per_frame) {
+    int32_t result = 0;
+    char ch_layout[64];
+    char args[512];
 
-    result = avfilter_init_str(abuffersrc_ctx, NULL);
-    if (result < 0) {
-        std::cout << "Failed Could not initialize the abuffer filter." << std::endl;
-        return result;
+    if (samples_per_frame <= 0) {
+        std::cerr << "Failed invalid frame size " << samples_per_frame << std::endl;
+        return AVERROR(EINVAL);
     }
+    frame_size = samples_per_frame;
 
-    /* 创建volumn滤镜 */
-    const AVFilter *volume = avfilter_get_by_name("volume");
-    if (!volume) {
-        std::cout << "Failed Could not find the volumn filter." << std::endl;
+    const AVFilter *abuffer = avfilter_get_by_name("abuffer");
+    const AVFilter *abuffersink = avfilter_get_by_name("abuffersink");
+    if (!abuffer || !abuffersink) {
+        std::cerr << "Failed Could not find the abuffer or abuffersink filter." << std::endl;
         return AVERROR_FILTER_NOT_FOUND;
     }
 
-    volume_ctx = avfilter_graph_alloc_filter(filter_graph, volume, "volume");
-    if (!volume_ctx) {
-        std::cout << "Failed Could not allocate the volume instance." << std::endl;
-        return AVERROR(ENOMEM);
-    }
-
-    av_dict_set(&options_dict, "volume", volume_factor, 0);
-    result = avfilter_init_dict(volume_ctx, &options_dict);
-    av_dict_free(&options_dict);
-    if (result < 0) {
-        std::cout << "Failed Could not initialize the volume filter." << std::endl;
-        return result;
-    }
-
-    /* 创建aformat滤镜 */
-    const AVFilter *aformat = avfilter_get_by_name("aformat");
-    if (!aformat) {
-        std::cout << "Failed Could not find the aformat filter." << std::endl;
-        return AVERROR_FILTER_NOT_FOUND;
-    }
+    AVFilterInOut *outputs = avfilter_inout_alloc();
+    AVFilterInOut *inputs = avfilter_inout_alloc();
+    do {
+        /* 创建滤镜图 */
+        filter_graph = avfilter_graph_alloc();
+        if (!outputs || !inputs || !filter_graph) {
+            std::cerr << "Failed Unable to create filter graph." << std::endl;
+            result = AVERROR(ENOMEM);
+            break;
+        }
 
-    aformat_ctx = avfilter_graph_alloc_filter(filter_graph, aformat, "aformat");
-    if (!aformat_ctx) {
-        std::cout << "Failed Could not allocate the aformat instance." << std::endl;
-        return AVERROR(ENOMEM);
-    }
+        /* 创建abuffer滤镜 */
+        const AVChannelLayout ch_layout_in = AV_CHANNEL_LAYOUT_STEREO;
+        av_channel_layout_describe(&ch_layout_in, ch_layout, sizeof(ch_layout));
+        snprintf(
+            args, sizeof(args), "time_base=1/%d:sample_rate=%d:sample_fmt=%s:channel_layout=%s", INPUT_SAMPLERATE,
+            INPUT_SAMPLERATE, av_get_sample_fmt_name(INPUT_FORMAT), ch_layout);
+        result = avfilter_graph_create_filter(&abuffersrc_ctx, abuffer, "in", args, NULL, filter_graph);
+        if (result < 0) {
+            std::cerr << "Failed Could not initialize the abuffer filter." << std::endl;
+            break;
+        }
 
-    snprintf(
-        options_str, sizeof(options_str), "sample_fmts=%s:sample_rates=%d:channel_layouts=0x%" PRIx64,
-        av_get_sample_fmt_name(AV_SAMPLE_FMT_S16), 22050, (uint64_t)AV_CH_LAYOUT_MONO);
-    result = avfilter_init_str(aformat_ctx, options_str);
-    if (result < 0) {
-        std::cout << "Failed Could not initialize the aformat filter." << std::endl;
-        return result;
-    }
+        /* 创建abuffersink滤镜，输出格式由滤镜描述决定，例如末尾的 aformat */
+        result = avfilter_graph_create_filter(&abuffersink_ctx, abuffersink, "out", NULL, NULL, filter_graph);
+        if (result < 0) {
+            std::cerr << "Failed Could not initialize the abuffersink instance." << std::endl;
+            break;
+        }
 
-    /* 创建abuffersink滤镜 */
-    const AVFilter *abuffersink = avfilter_get_by_name("abuffersink");
-    if (!abuffersink) {
-        std::cout << "Failed Could not find the abuffersink filter." << std::endl;
-        return AVERROR_FILTER_NOT_FOUND;
-    }
+        outputs->name = av_strdup("in");
+        outputs->filter_ctx = abuffersrc_ctx;
+        outputs->pad_idx = 0;
+        outputs->next = NULL;
 
-    abuffersink_ctx = avfilter_graph_alloc_filter(filter_graph, abuffersink, "sink");
-    if (!abuffersink_ctx) {
-        std::cout << "Failed Could not allocate the abuffersink instance." << std::endl;
-        return AVERROR(ENOMEM);
-    }
+        inputs->name = av_strdup("out");
+        inputs->filter_ctx = abuffersink_ctx;
+        inputs->pad_idx = 0;
+        inputs->next = NULL;
 
-    result = avfilter_init_str(abuffersink_ctx, NULL);
-    if (result < 0) {
-        std::cout << "Failed Could not initialize the abuffersink instance." << std::endl;
-        return result;
-    }
+        /* 解析滤镜描述并连接到输入输出 */
+        result = avfilter_graph_parse_ptr(filter_graph, filter_describe, &inputs, &outputs, NULL);
+        if (result < 0) {
+            std::cerr << "Failed parse filter description: " << std::string(filter_describe) << std::endl;
+            break;
+        }
 
-    /* 连接创建好的滤镜 */
-    result = avfilter_link(abuffersrc_ctx, 0, volume_ctx, 0);
-    if (result >= 0) result = avfilter_link(volume_ctx, 0, aformat_ctx, 0);
-    if (result >= 0) result = avfilter_link(aformat_ctx, 0, abuffersink_ctx, 0);
-    if (result < 0) {
-        fprintf(stderr, "Error connecting filters\n");
-        return result;
-    }
+        /* 配置滤镜图 */
+        result = avfilter_graph_config(filter_graph, NULL);
+        if (result < 0) {
+            std::cerr << "Failed Error configuring the filter graph." << std::endl;
+            break;
+        }
+    } while (0);
 
-    /* 配置滤镜图 */
-    result = avfilter_graph_config(filter_graph, NULL);
-    if (result < 0) {
-        std::cout << "Failed Error configuring the filter graph." << std::endl;
-        return result;
-    }
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    if (result < 0) { return result; }
 
-    /* 创建输入帧对象和输出帧对象 */
+    /* 创建输入帧池和输出帧对象，处理过程中不再分配 */
     input_frame = av_frame_alloc();
-    if (!input_frame) {
-        std::cerr << "Failed could not alloc input frame." << std::endl;
+    output_frame = av_frame_alloc();
+    if (!input_frame || !output_frame) {
+        std::cerr << "Failed could not alloc frames." << std::endl;
         return -1;
     }
 
-    output_frame = av_frame_alloc();
-    if (!output_frame) {
-        std::cerr << "Failed could not alloc input frame." << std::endl;
-        return -1;
+    input_frame->sample_rate = INPUT_SAMPLERATE;
+    input_frame->nb_samples = frame_size;
+    input_frame->format = INPUT_FORMAT;
+    input_frame->ch_layout = AV_CHANNEL_LAYOUT_STEREO;
+    result = input_pool.init(input_frame, INPUT_POOL_DEPTH);
+    if (result < 0) {
+        std::cerr << "Failed allocating input frame pool." << std::endl;
+        return result;
     }
 
-    return result;
+    read_buffer.resize((size_t)frame_size * INPUT_CHANNELS * av_get_bytes_per_sample(INPUT_FORMAT));
+    read_buffered = 0;
+    return 0;
 }
 
-static int32_t filter_frame() {
-    int32_t result = av_buffersrc_add_frame(abuffersrc_ctx, input_frame);
+// frame 为 nullptr 时冲刷滤镜图，取出所有剩余的输出
+static int32_t filter_frame(AVFrame *frame) {
+    // 不带 KEEP_REF 标志，引用直接转交给滤镜图，滤镜图用完后池中的缓冲区即可复用
+    int32_t result = av_buffersrc_add_frame_flags(abuffersrc_ctx, frame, 0);
     if (result < 0) {
         std::cerr << "Failedadd frame to buffersrc failed." << std::endl;
         return result;
@@ -181,58 +165,149 @@ static int32_t filter_frame() {
             std::cerr << "Failed buffersink_get_frame failed." << std::endl;
             return result;
         }
-        std::cout << "Output channels:" << output_frame->ch_layout.nb_channels << ", nb_samples : " << output_frame->nb_samples
-                  << ", sample_fmt : " << output_frame->format << std::endl;
-        write_samples_to_pcm2(output_frame, (AVSampleFormat)output_frame->format, output_frame->ch_layout.nb_channels);
+        output_samples += output_frame->nb_samples;
+        if (output_callback) {
+            result = output_callback(output_frame);
+        } else {
+            result = write_samples_to_pcm2(
+                output_frame, (AVSampleFormat)output_frame->format, output_frame->ch_layout.nb_channels);
+        }
         av_frame_unref(output_frame);
+        if (result < 0) {
+            std::cerr << "Failed write output frame failed." << std::endl;
+            return result;
+        }
     }
 
     return result;
 }
 
-static int32_t init_frame() {
-    input_frame->sample_rate = INPUT_SAMPLERATE;
-    input_frame->nb_samples = FRAME_SIZE;
-    input_frame->format = INPUT_FORMAT;
-    // input_frame->channel_layout = INPUT_CHANNEL_LAYOUT;
-    input_frame->ch_layout = AV_CHANNEL_LAYOUT_STEREO;
-    // input_frame->channels = av_get_channel_layout_nb_channels(INPUT_CHANNEL_LAYOUT);
-    int32_t result = av_frame_get_buffer(input_frame, 0);
-    if (result < 0) {
-        std::cerr << "Failed AVFrame could not get buffer." << std::endl;
+// 从池中取帧，把交错存放的样本拆分到各声道平面；最后一次读取不足一帧时按实际样本数送入
+static int32_t read_frame(int32_t &nb_samples) {
+    int32_t bytes_per_sample = av_get_bytes_per_sample(INPUT_FORMAT);
+    int32_t sample_bytes = bytes_per_sample * INPUT_CHANNELS;
+
+    int32_t read_size = 0;
+    if (read_data_to_buf(
+            read_buffer.data() + read_buffered, (int32_t)(read_buffer.size() - read_buffered), read_size)
+        < 0) {
+        if (end_of_input_file()) {
+            nb_samples = 0;
+            return 0;
+        }
+        std::cerr << "Failed read pcm data failed." << std::endl;
         return -1;
     }
+    read_buffered += read_size;
+    nb_samples = (int32_t)(read_buffered / sample_bytes);
+    if (nb_samples == 0) { return 0; }
+
+    int32_t result = input_pool.get_frame(input_frame);
+    if (result < 0) {
+        std::cerr << "Failed get frame from input pool failed." << std::endl;
+        return result;
+    }
+    input_frame->nb_samples = nb_samples;
+
+    const uint8_t *src = read_buffer.data();
+    for (int32_t i = 0; i < nb_samples; i++) {
+        for (int32_t ch = 0; ch < INPUT_CHANNELS; ch++) {
+            memcpy(input_frame->data[ch] + bytes_per_sample * i, src, bytes_per_sample);
+            src += bytes_per_sample;
+        }
+    }
+
+    size_t used = (size_t)nb_samples * sample_bytes;
+    memmove(read_buffer.data(), read_buffer.data() + used, read_buffered - used);
+    read_buffered -= used;
     return 0;
 }
 
 int32_t audio_filtering() {
     int32_t result = 0;
+    auto start = std::chrono::steady_clock::now();
     while (!end_of_input_file()) {
-        result = init_frame();
+        int32_t nb_samples = 0;
+        result = read_frame(nb_samples);
         if (result < 0) {
-            std::cerr << "Failed init_frame failed." << std::endl;
+            std::cerr << "Failed read_frame failed." << std::endl;
             return result;
         }
-        result = read_pcm_to_frame2(input_frame, INPUT_FORMAT, 2);
-        if (result < 0) {
-            std::cerr << "Failed read_pcm_to_frame failed." << std::endl;
-            return -1;
-        }
-        result = filter_frame();
+        if (nb_samples == 0) { continue; }
+
+        input_frame->pts = next_pts;
+        next_pts += nb_samples;
+        input_samples += nb_samples;
+        result = filter_frame(input_frame);
         if (result < 0) {
             std::cerr << "Failed filter_frame failed." << std::endl;
             return -1;
         }
     }
-    return result;
+
+    // 取出滤镜内部缓存的样本（重采样延迟、帧大小对齐等）
+    result = filter_frame(nullptr);
+    if (result < 0) {
+        std::cerr << "Failed flush filter graph failed." << std::endl;
+        return result;
+    }
+    filter_time_us +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+int32_t send_audio_filter_command(const char *target, const char *cmd, const char *arg) {
+    char response[256] = {0};
+    int32_t result = avfilter_graph_send_command(filter_graph, target, cmd, arg, response, sizeof(response), 0);
+    if (result < 0) {
+        std::cerr << "Failed send command " << std::string(cmd) << " to " << std::string(target) << std::endl;
+        return result;
+    }
+    if (response[0]) { std::cout << "Filter response: " << response << std::endl; }
+    return 0;
+}
+
+int32_t queue_audio_filter_command(const char *target, const char *cmd, const char *arg, double ts) {
+    int32_t result = avfilter_graph_queue_command(filter_graph, target, cmd, arg, 0, ts);
+    if (result < 0) {
+        std::cerr << "Failed queue command " << std::string(cmd) << " to " << std::string(target) << std::endl;
+        return result;
+    }
+    return 0;
+}
+
+// ts < 0 时立即生效，否则从时间戳 >= ts(秒) 的第一帧开始生效；
+// 目标按滤镜名匹配，滤镜描述中的所有 volume 实例都会收到命令
+int32_t set_audio_volume(const char *volume, double ts) {
+    if (ts < 0) { return send_audio_filter_command("volume", "volume", volume); }
+    return queue_audio_filter_command("volume", "volume", volume, ts);
+}
+
+void print_audio_filter_stats() {
+    double seconds = filter_time_us / 1000000.0;
+    std::cout << "Audio filter frame size:" << frame_size << " ("
+              << frame_size * 1000.0 / INPUT_SAMPLERATE << "ms), input samples:" << input_samples
+              << ", output samples:" << output_samples << ", time:" << filter_time_us / 1000.0 << "ms";
+    if (seconds > 0) { std::cout << ", speed:" << input_samples / seconds / INPUT_SAMPLERATE << "x realtime"; }
+    std::cout << ", input pool:" << input_pool.size() << " frames" << std::endl;
 }
 
 static void free_frames() {
     av_frame_free(&input_frame);
+    input_pool.uninit();
     av_frame_free(&output_frame);
+    std::vector<uint8_t>().swap(read_buffer);
+    read_buffered = 0;
 }
 
 void destroy_audio_filter() {
+    next_pts = 0;
+    input_samples = 0;
+    output_samples = 0;
+    filter_time_us = 0;
+    output_callback = nullptr;
     free_frames();
     avfilter_graph_free(&filter_graph);
+    abuffersrc_ctx = nullptr;
+    abuffersink_ctx = nullptr;
 }
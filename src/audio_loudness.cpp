@@ -0,0 +1,202 @@
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+extern "C" {
+#include <libavutil/dict.h>
+#include <libavutil/frame.h>
+}
+
+#include "audio_filter_core.h"
+#include "audio_loudness.h"
+#include "io_data.h"
+
+// 分析只需要完整地走一遍样本，大帧减少滤镜调用次数；
+// ebur128 只接受 48kHz，filter_size=8 的重采样比默认的 32 阶便宜得多，对响度测量的影响可以忽略
+#define ANALYSIS_FRAME_SIZE  65536
+#define ANALYSIS_FILTER      "aresample=48000:filter_size=8,ebur128=metadata=1:peak=sample:framelog=quiet"
+#define NORMALIZE_FRAME_SIZE 4096
+#define SILENCE_LUFS         -70.0  // ebur128 的绝对门限，整段都低于它时报告为 -70
+#define MIN_PEAK_DB          -120.0 // 全静音时峰值为 -inf，限制到有限值以便写入缓存
+// 缓存格式变化时递增，旧版本的缓存文件按失效处理（版本 1 把线性峰值当作 dBFS 保存）
+#define LOUDNESS_CACHE_VERSION 2
+
+static std::string cache_file_name(const char *input_file) {
+    return std::string(input_file) + ".loudness";
+}
+
+static int32_t get_file_signature(const char *input_file, int64_t &size, int64_t &mtime) {
+    struct stat info;
+    if (stat(input_file, &info) != 0) {
+        std::cerr << "Error: cannot stat " << std::string(input_file) << std::endl;
+        return -1;
+    }
+    size = (int64_t)info.st_size;
+    mtime = (int64_t)info.st_mtime;
+    return 0;
+}
+
+static bool read_metadata(const AVDictionary *metadata, const char *key, double &value) {
+    const AVDictionaryEntry *entry = av_dict_get(metadata, key, nullptr, 0);
+    if (!entry) { return false; }
+    value = atof(entry->value);
+    return true;
+}
+
+int32_t analyze_loudness(const char *input_file, LoudnessStats &stats) {
+    // 每 100ms 更新一次的累计值，最后一次就是整段的结果
+    bool measured = false;
+    double sample_peak = 0.0; // ebur128 报告的是线性幅度 (0..1)
+    stats.integrated = stats.range = stats.peak = 0.0;
+    set_audio_filter_output([&](AVFrame *frame) -> int32_t {
+        if (read_metadata(frame->metadata, "lavfi.r128.I", stats.integrated)) { measured = true; }
+        read_metadata(frame->metadata, "lavfi.r128.LRA", stats.range);
+        read_metadata(frame->metadata, "lavfi.r128.sample_peak", sample_peak);
+        return 0;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    int32_t result = open_input_file(input_file);
+    do {
+        if (result < 0) { break; }
+        result = init_audio_filter(ANALYSIS_FILTER, ANALYSIS_FRAME_SIZE);
+        if (result < 0) { break; }
+        result = audio_filtering();
+        if (result < 0) { break; }
+    } while (0);
+    destroy_audio_filter();
+    close_input_output_files();
+
+    if (result < 0) { return result; }
+    stats.peak = sample_peak > 0.0 ? 20.0 * log10(sample_peak) : MIN_PEAK_DB;
+    if (stats.peak < MIN_PEAK_DB) { stats.peak = MIN_PEAK_DB; }
+    if (!measured) {
+        std::cerr << "Error: input too short for loudness measurement." << std::endl;
+        return -1;
+    }
+
+    int64_t elapsed_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loudness analysis: I=" << stats.integrated << " LUFS, LRA=" << stats.range
+              << " LU, peak=" << stats.peak << " dBFS, time:" << elapsed_us / 1000.0 << "ms" << std::endl;
+    return 0;
+}
+
+int32_t load_loudness_cache(const char *input_file, LoudnessStats &stats) {
+    int64_t size = 0, mtime = 0;
+    if (get_file_signature(input_file, size, mtime) < 0) { return -1; }
+
+    std::ifstream file(cache_file_name(input_file));
+    if (!file) { return -1; }
+
+    int64_t cached_size = -1, cached_mtime = -1;
+    int32_t cached_version = 0, fields = 0;
+    std::string key;
+    while (file >> key) {
+        if (key == "version") {
+            file >> cached_version;
+        } else if (key == "size") {
+            file >> cached_size;
+        } else if (key == "mtime") {
+            file >> cached_mtime;
+        } else if (key == "integrated") {
+            file >> stats.integrated;
+            fields++;
+        } else if (key == "range") {
+            file >> stats.range;
+            fields++;
+        } else if (key == "peak") {
+            file >> stats.peak;
+            fields++;
+        } else {
+            std::string ignored;
+            file >> ignored;
+        }
+    }
+
+    if (cached_version != LOUDNESS_CACHE_VERSION || cached_size != size || cached_mtime != mtime || fields != 3) {
+        std::cout << "Loudness cache for " << std::string(input_file) << " is stale." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t save_loudness_cache(const char *input_file, const LoudnessStats &stats) {
+    int64_t size = 0, mtime = 0;
+    if (get_file_signature(input_file, size, mtime) < 0) { return -1; }
+
+    // 先写临时文件再改名，并发运行的进程不会读到写了一半的缓存
+    std::string cache_file = cache_file_name(input_file);
+    std::string temp_file = cache_file + ".tmp";
+    {
+        std::ofstream file(temp_file, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error: cannot write " << temp_file << std::endl;
+            return -1;
+        }
+        file.precision(17);
+        file << "version " << LOUDNESS_CACHE_VERSION << "\nsize " << size << "\nmtime " << mtime << "\nintegrated "
+             << stats.integrated << "\nrange " << stats.range << "\npeak " << stats.peak << "\n";
+        if (!file) {
+            std::cerr << "Error: cannot write " << temp_file << std::endl;
+            return -1;
+        }
+    }
+    if (rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+        std::cerr << "Error: cannot rename " << temp_file << std::endl;
+        remove(temp_file.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+double compute_loudness_gain(const LoudnessStats &stats, double target_lufs, double peak_limit) {
+    // 静音不做增益，否则会把底噪放大几十 dB
+    if (stats.integrated <= SILENCE_LUFS) { return 0.0; }
+    double gain = target_lufs - stats.integrated;
+    if (stats.peak + gain > peak_limit) { gain = peak_limit - stats.peak; }
+    return gain;
+}
+
+int32_t normalize_loudness(
+    const char *input_file,
+    const char *output_file,
+    double target_lufs,
+    double peak_limit,
+    bool use_cache) {
+    LoudnessStats stats;
+    int32_t result = 0;
+    if (use_cache && load_loudness_cache(input_file, stats) >= 0) {
+        std::cout << "Loudness cache hit: I=" << stats.integrated << " LUFS, peak=" << stats.peak << " dBFS"
+                  << std::endl;
+    } else {
+        result = analyze_loudness(input_file, stats);
+        if (result < 0) { return result; }
+        // 缓存写入失败不影响本次归一化
+        if (use_cache) { save_loudness_cache(input_file, stats); }
+    }
+
+    double gain = compute_loudness_gain(stats, target_lufs, peak_limit);
+    char filter_descr[64];
+    snprintf(filter_descr, sizeof(filter_descr), "volume=%.2fdB", gain);
+    std::cout << "Loudness gain: " << gain << " dB (target " << target_lufs << " LUFS)" << std::endl;
+
+    result = open_input_output_files(input_file, output_file);
+    do {
+        if (result < 0) { break; }
+        result = init_audio_filter(filter_descr, NORMALIZE_FRAME_SIZE);
+        if (result < 0) { break; }
+        result = audio_filtering();
+        if (result < 0) { break; }
+        print_audio_filter_stats();
+    } while (0);
+    destroy_audio_filter();
+    close_input_output_files();
+    return result;
+}
@@ -0,0 +1,359 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/cpu.h>
+#include <libavutil/samplefmt.h>
+}
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define HAVE_AVX2_KERNELS 1
+#define TARGET_AVX2       __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_KERNELS 1
+#endif
+
+#include "audio_mixer.h"
+
+#define OUTPUT_POOL_DEPTH 2
+#define LIMITER_RELEASE_S 0.2 // 限幅后增益恢复的时间常数
+
+// ---------------------------------------------------------------------------
+// 样本内核：加权累加、削波与峰值
+
+static void mix_add_c(float *dst, const float *src, float gain, int32_t count, int32_t start) {
+    for (int32_t i = start; i < count; i++) { dst[i] += src[i] * gain; }
+}
+
+static void clip_c(float *dst, float limit, int32_t count, int32_t start) {
+    for (int32_t i = start; i < count; i++) { dst[i] = dst[i] > limit ? limit : (dst[i] < -limit ? -limit : dst[i]); }
+}
+
+static float peak_c(const float *src, int32_t count, int32_t start, float peak) {
+    for (int32_t i = start; i < count; i++) { peak = fabsf(src[i]) > peak ? fabsf(src[i]) : peak; }
+    return peak;
+}
+
+#if HAVE_AVX2_KERNELS
+TARGET_AVX2 static void mix_add_avx2(float *dst, const float *src, float gain, int32_t count) {
+    const __m256 g = _mm256_set1_ps(gain);
+    int32_t i = 0;
+    // 每次处理 16 个样本，两条独立的加法链掩盖延迟
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+        __m256 b = _mm256_add_ps(_mm256_loadu_ps(dst + i + 8), _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), g));
+        _mm256_storeu_ps(dst + i, a);
+        _mm256_storeu_ps(dst + i + 8, b);
+    }
+    mix_add_c(dst, src, gain, count, i);
+}
+
+TARGET_AVX2 static void clip_avx2(float *dst, float limit, int32_t count) {
+    const __m256 hi = _mm256_set1_ps(limit), lo = _mm256_set1_ps(-limit);
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(dst + i), hi), lo));
+    }
+    clip_c(dst, limit, count, i);
+}
+
+TARGET_AVX2 static float peak_avx2(const float *src, int32_t count) {
+    // 清掉符号位即为绝对值
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 peak = _mm256_setzero_ps();
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) { peak = _mm256_max_ps(peak, _mm256_and_ps(_mm256_loadu_ps(src + i), abs_mask)); }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, peak);
+    return peak_c(lanes, 8, 0, peak_c(src, count, i, 0.0f));
+}
+#endif
+
+#if HAVE_NEON_KERNELS
+static void mix_add_neon(float *dst, const float *src, float gain, int32_t count) {
+    int32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain));
+        vst1q_f32(dst + i + 4, vmlaq_n_f32(vld1q_f32(dst + i + 4), vld1q_f32(src + i + 4), gain));
+    }
+    mix_add_c(dst, src, gain, count, i);
+}
+
+static void clip_neon(float *dst, float limit, int32_t count) {
+    const float32x4_t hi = vdupq_n_f32(limit), lo = vdupq_n_f32(-limit);
+    int32_t i = 0;
+    for (; i + 4 <= count; i += 4) { vst1q_f32(dst + i, vmaxq_f32(vminq_f32(vld1q_f32(dst + i), hi), lo)); }
+    clip_c(dst, limit, count, i);
+}
+#endif
+
+static void mix_add(float *dst, const float *src, float gain, int32_t count) {
+#if HAVE_AVX2_KERNELS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+        mix_add_avx2(dst, src, gain, count);
+        return;
+    }
+#endif
+#if HAVE_NEON_KERNELS
+    mix_add_neon(dst, src, gain, count);
+#else
+    mix_add_c(dst, src, gain, count, 0);
+#endif
+}
+
+static void clip(float *dst, float limit, int32_t count) {
+#if HAVE_AVX2_KERNELS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+        clip_avx2(dst, limit, count);
+        return;
+    }
+#endif
+#if HAVE_NEON_KERNELS
+    clip_neon(dst, limit, count);
+#else
+    clip_c(dst, limit, count, 0);
+#endif
+}
+
+static float peak(const float *src, int32_t count) {
+#if HAVE_AVX2_KERNELS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) { return peak_avx2(src, count); }
+#endif
+    return peak_c(src, count, 0, 0.0f);
+}
+
+// 增益从 from 线性过渡到 to，写成 from + step * i 便于编译器向量化
+static void ramp(float *dst, float from, float to, int32_t count) {
+    float step = (to - from) / count;
+    for (int32_t i = 0; i < count; i++) { dst[i] *= from + step * i; }
+}
+
+// ---------------------------------------------------------------------------
+// AudioMixer
+
+AudioMixer::~AudioMixer() {
+    uninit();
+}
+
+int32_t AudioMixer::init(
+    int32_t nb_inputs,
+    int32_t sample_rate,
+    const AVChannelLayout &ch_layout,
+    int32_t frame_size,
+    int32_t capacity) {
+    if (!inputs_.empty()) {
+        std::cerr << "Error: audio mixer already initialized." << std::endl;
+        return -1;
+    }
+    if (nb_inputs <= 0 || sample_rate <= 0 || frame_size <= 0 || capacity < frame_size) {
+        std::cerr << "Error: invalid audio mixer parameters." << std::endl;
+        return AVERROR(EINVAL);
+    }
+
+    channels_ = ch_layout.nb_channels;
+    sample_rate_ = sample_rate;
+    frame_size_ = frame_size;
+    capacity_ = capacity;
+    next_pts_ = 0;
+    limiter_gain_ = 1.0f;
+
+    inputs_.resize(nb_inputs);
+    for (size_t i = 0; i < inputs_.size(); i++) {
+        inputs_[i].samples.assign((size_t)channels_ * capacity_, 0.0f);
+        inputs_[i].pts = 0;
+        inputs_[i].head = 0;
+        inputs_[i].count = 0;
+        inputs_[i].gain = 1.0f;
+        inputs_[i].finished = false;
+    }
+
+    AVFrame *frame_template = av_frame_alloc();
+    if (!frame_template) {
+        std::cerr << "Error: frame allocation failed." << std::endl;
+        return -1;
+    }
+    frame_template->nb_samples = frame_size_;
+    frame_template->format = AV_SAMPLE_FMT_FLTP;
+    frame_template->sample_rate = sample_rate_;
+    int32_t result = av_channel_layout_copy(&frame_template->ch_layout, &ch_layout);
+    if (result >= 0) { result = output_pool_.init(frame_template, OUTPUT_POOL_DEPTH); }
+    av_frame_free(&frame_template);
+    if (result < 0) {
+        std::cerr << "Error: could not allocate mixer output pool." << std::endl;
+        return result;
+    }
+    return 0;
+}
+
+void AudioMixer::uninit() {
+    inputs_.clear();
+    output_pool_.uninit();
+    channels_ = 0;
+}
+
+int32_t AudioMixer::set_gain(int32_t input, float gain) {
+    if (input < 0 || input >= (int32_t)inputs_.size()) { return AVERROR(EINVAL); }
+    inputs_[input].gain = gain;
+    return 0;
+}
+
+void AudioMixer::set_clip_mode(AudioMixerClipMode mode, float threshold) {
+    clip_mode_ = mode;
+    threshold_ = threshold;
+    limiter_gain_ = 1.0f;
+}
+
+int32_t AudioMixer::send_frame(int32_t input, const AVFrame *frame) {
+    if (input < 0 || input >= (int32_t)inputs_.size()) { return AVERROR(EINVAL); }
+    Input &in = inputs_[input];
+    if (in.finished) { return AVERROR_EOF; }
+    if (!frame) {
+        in.finished = true;
+        return 0;
+    }
+    if (frame->format != AV_SAMPLE_FMT_FLTP || frame->ch_layout.nb_channels != channels_
+        || frame->sample_rate != sample_rate_) {
+        std::cerr << "Error: mixer input " << input << " does not match the output format." << std::endl;
+        return AVERROR(EINVAL);
+    }
+
+    // 没有时间戳的帧接在上一帧之后
+    int64_t end = in.pts + in.count;
+    int64_t pts = frame->pts == AV_NOPTS_VALUE ? (in.count ? end : next_pts_) : frame->pts;
+
+    // 丢弃已经输出过的或与缓冲重叠的样本
+    int64_t lower = in.count ? end : next_pts_;
+    int32_t skip = 0;
+    if (pts < lower) {
+        skip = (int32_t)FFMIN((int64_t)frame->nb_samples, lower - pts);
+        pts += skip;
+    }
+    int32_t nb_samples = frame->nb_samples - skip;
+    if (nb_samples == 0) { return 0; }
+    if (nb_samples > capacity_) {
+        std::cerr << "Error: mixer input frame larger than the input buffer." << std::endl;
+        return AVERROR(EINVAL);
+    }
+
+    // 缓冲为空时直接从帧的位置开始；否则空隙补静音，空隙太长时先等输出取走缓冲
+    int64_t gap = in.count ? pts - end : 0;
+    if (gap + nb_samples > capacity_ - in.count) { return AVERROR(EAGAIN); }
+    if (!in.count) {
+        in.pts = pts;
+        in.head = 0;
+    }
+
+    int32_t tail = (in.head + in.count) % capacity_;
+    for (int32_t ch = 0; ch < channels_; ch++) {
+        float *ring = in.samples.data() + (size_t)ch * capacity_;
+        const float *src = (const float *)frame->extended_data[ch] + skip;
+        int32_t pos = tail;
+        for (int64_t i = 0; i < gap; i++) {
+            ring[pos] = 0.0f;
+            pos = pos + 1 == capacity_ ? 0 : pos + 1;
+        }
+        int32_t first = FFMIN(nb_samples, capacity_ - pos);
+        memcpy(ring + pos, src, first * sizeof(float));
+        memcpy(ring, src + first, (nb_samples - first) * sizeof(float));
+    }
+    in.count += (int32_t)gap + nb_samples;
+    return 0;
+}
+
+// 把输入与 [next_pts_, next_pts_ + nb_samples) 重叠的部分加到输出，并丢弃这段之前的样本
+void AudioMixer::mix_input(Input &in, AVFrame *frame, int32_t nb_samples) {
+    int64_t block_end = next_pts_ + nb_samples;
+    int64_t start = FFMAX(in.pts, next_pts_);
+    int64_t stop = FFMIN(in.pts + in.count, block_end);
+
+    if (start < stop && in.gain != 0.0f) {
+        int32_t src_offset = (int32_t)(start - in.pts);
+        int32_t dst_offset = (int32_t)(start - next_pts_);
+        int32_t length = (int32_t)(stop - start);
+        int32_t pos = (in.head + src_offset) % capacity_;
+        int32_t first = FFMIN(length, capacity_ - pos);
+        for (int32_t ch = 0; ch < channels_; ch++) {
+            const float *ring = in.samples.data() + (size_t)ch * capacity_;
+            float *dst = (float *)frame->extended_data[ch] + dst_offset;
+            mix_add(dst, ring + pos, in.gain, first);
+            if (first < length) { mix_add(dst + first, ring, in.gain, length - first); }
+        }
+    }
+
+    int32_t consumed = (int32_t)FFMAX((int64_t)0, FFMIN((int64_t)in.count, block_end - in.pts));
+    in.head = (in.head + consumed) % capacity_;
+    in.count -= consumed;
+    in.pts += consumed;
+}
+
+void AudioMixer::apply_clip(AVFrame *frame, int32_t nb_samples) {
+    if (clip_mode_ == AUDIO_MIX_CLIP_NONE) { return; }
+
+    if (clip_mode_ == AUDIO_MIX_CLIP_LIMIT) {
+        float level = 0.0f;
+        for (int32_t ch = 0; ch < channels_; ch++) {
+            level = FFMAX(level, peak((const float *)frame->extended_data[ch], nb_samples));
+        }
+        // 没有预读，压低增益时从上一块的增益开始过渡，块首的过冲由后面的硬削波处理
+        float desired = level > threshold_ ? threshold_ / level : 1.0f;
+        float release = (float)(1.0 - exp(-nb_samples / (LIMITER_RELEASE_S * sample_rate_)));
+        float next = desired < limiter_gain_ ? desired : limiter_gain_ + (desired - limiter_gain_) * release;
+        if (limiter_gain_ != 1.0f || next != 1.0f) {
+            for (int32_t ch = 0; ch < channels_; ch++) {
+                ramp((float *)frame->extended_data[ch], limiter_gain_, next, nb_samples);
+            }
+        }
+        limiter_gain_ = next;
+    }
+
+    for (int32_t ch = 0; ch < channels_; ch++) { clip((float *)frame->extended_data[ch], threshold_, nb_samples); }
+}
+
+int32_t AudioMixer::receive_frame(AVFrame *frame) {
+    if (inputs_.empty()) {
+        std::cerr << "Error: audio mixer is not initialized." << std::endl;
+        return -1;
+    }
+
+    int64_t block_end = next_pts_ + frame_size_;
+    int64_t last_end = next_pts_;
+    bool all_finished = true;
+    for (size_t i = 0; i < inputs_.size(); i++) {
+        const Input &in = inputs_[i];
+        if (in.finished) {
+            if (in.count) { last_end = FFMAX(last_end, in.pts + in.count); }
+            continue;
+        }
+        all_finished = false;
+        // 缓冲的数据从块之后才开始时，这一块里该输入就是静音
+        if (!in.count || (in.pts < block_end && in.pts + in.count < block_end)) { return AVERROR(EAGAIN); }
+    }
+
+    int32_t nb_samples = frame_size_;
+    if (all_finished) {
+        if (last_end <= next_pts_) { return AVERROR_EOF; }
+        nb_samples = (int32_t)FFMIN((int64_t)frame_size_, last_end - next_pts_);
+    }
+
+    int32_t result = output_pool_.get_frame(frame);
+    if (result < 0) { return result; }
+    frame->nb_samples = nb_samples;
+    frame->pts = next_pts_;
+    for (int32_t ch = 0; ch < channels_; ch++) { memset(frame->extended_data[ch], 0, nb_samples * sizeof(float)); }
+
+    for (size_t i = 0; i < inputs_.size(); i++) {
+        if (inputs_[i].count) { mix_input(inputs_[i], frame, nb_samples); }
+    }
+    apply_clip(frame, nb_samples);
+
+    next_pts_ += nb_samples;
+    return 0;
+}
@@ -1,11 +1,19 @@
+#include <cctype>
+#include <climits>
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include <libavutil/channel_layout.h>
 #include <libavutil/frame.h>
+#include <libavutil/mathematics.h>
 #include <libavutil/opt.h>
 #include <libavutil/samplefmt.h>
 #include <libswresample/swresample.h>
@@ -13,30 +21,139 @@ extern "C" {
 
 #include "io_data.h"
 #include "audio_resampler_core.h"
-
-#define SRC_NB_SAMPLES 1152
+#include "thread_pool.h"
 
 static struct SwrContext *swr_ctx;
-static AVFrame *input_frame = nullptr;
-int32_t dst_nb_samples, max_dst_nb_samples, dst_nb_channels, dst_rate, src_rate;
+static AVChannelLayout src_ch_layout, dst_ch_layout;
+int32_t dst_nb_samples, max_dst_nb_samples, src_nb_channels, dst_nb_channels, dst_rate, src_rate;
 enum AVSampleFormat src_sample_fmt = AV_SAMPLE_FMT_NONE, dst_sample_fmt = AV_SAMPLE_FMT_NONE;
 uint8_t **dst_data = NULL;
 int32_t dst_linesize = 0;
 
-static int32_t init_frame(int sample_rate, int sample_format, uint64_t channel_layout) {
-    int32_t result = 0;
-    input_frame->sample_rate = sample_rate;
-    input_frame->nb_samples = SRC_NB_SAMPLES;
-    input_frame->format = sample_format;
-    input_frame->ch_layout.nb_channels = channel_layout;
+static int32_t resampler_level = 1;
+static bool use_soxr = false;
+static std::vector<double> matrix_coefficients; // 为空时使用 libswresample 的默认矩阵
+
+static AudioResamplerOutputCallback output_callback;
+static std::vector<uint8_t> read_buffer; // 交错存放的输入样本，保存不足一个样本的剩余字节
+static size_t read_buffered = 0;
+
+static int64_t input_samples = 0, output_samples = 0;
+static int64_t convert_time_us = 0;
+
+// 质量档位对应的参数。swr 为多相 FIR：滤波器越长、相位越多，阻带衰减越高，开销也越大；
+// soxr 的 precision 为目标精度(bit)，16 约等于 CD 质量，28 接近 float 的极限
+static const char *quality_names[] = {"low", "medium", "high"};
+static const int32_t swr_filter_sizes[] = {8, 32, 64};
+static const int32_t swr_phase_shifts[] = {6, 10, 12};
+static const int32_t soxr_precisions[] = {16, 20, 28};
+
+static int32_t parse_resampler_engine(const char *engine, const char *quality) {
+    resampler_level = -1;
+    for (int32_t i = 0; i < 3; i++) {
+        if (!strcasecmp(quality, quality_names[i])) { resampler_level = i; }
+    }
+    if (resampler_level < 0) {
+        std::cerr << "Error: unsupported resampler quality " << std::string(quality) << std::endl;
+        return -1;
+    }
+
+    if (!strcasecmp(engine, "soxr")) {
+        use_soxr = true;
+    } else if (!strcasecmp(engine, "swr")) {
+        use_soxr = false;
+    } else {
+        std::cerr << "Error: unsupported resampler engine " << std::string(engine) << std::endl;
+        return -1;
+    }
+    return 0;
+}
 
-    result = av_frame_get_buffer(input_frame, 0);
+// 按 init_audio_resampler 解析出的参数创建并初始化一个重采样器，并行模式下每个块各用一个
+static int32_t create_swr_context(struct SwrContext **ctx) {
+    // 声道重排、重采样与格式转换在同一次 swr_convert 中完成
+    int32_t result = swr_alloc_set_opts2(
+        ctx, &dst_ch_layout, dst_sample_fmt, dst_rate, &src_ch_layout, src_sample_fmt, src_rate, 0, NULL);
     if (result < 0) {
-        std::cerr << "Error: AVFrame could not get buffer." << std::endl;
+        std::cerr << "Error: failed to allocate SwrContext." << std::endl;
         return -1;
     }
 
-    return result;
+    if (use_soxr) {
+        result = av_opt_set(*ctx, "resampler", "soxr", 0);
+        if (result >= 0) { result = av_opt_set_double(*ctx, "precision", soxr_precisions[resampler_level], 0); }
+    } else {
+        result = av_opt_set_int(*ctx, "filter_size", swr_filter_sizes[resampler_level], 0);
+        if (result >= 0) { result = av_opt_set_int(*ctx, "phase_shift", swr_phase_shifts[resampler_level], 0); }
+        if (result >= 0) { result = av_opt_set_int(*ctx, "linear_interp", 1, 0); }
+    }
+    if (result < 0) {
+        std::cerr << "Error: failed to set resampler options." << std::endl;
+        return -1;
+    }
+
+    if (!matrix_coefficients.empty()) {
+        result = swr_set_matrix(*ctx, matrix_coefficients.data(), src_ch_layout.nb_channels);
+        if (result < 0) {
+            std::cerr << "Error: failed to set rematrix coefficients." << std::endl;
+            return -1;
+        }
+    }
+
+    result = swr_init(*ctx);
+    if (result < 0) {
+        // FFmpeg 编译时没有启用 libsoxr 时也会在这里失败
+        std::cerr << "Error: failed to initialize SwrContext." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// 接受 libavutil 的所有写法："mono"、"stereo"、"5.1"、"7.1"、"ambisonic 1"、"FL+FR+LFE"、"6c" 等，
+// 旧的大写名称（"STEREO"、"SURROUND"）按小写再解析一次
+static int32_t parse_ch_layout(const char *describe, AVChannelLayout &layout) {
+    if (av_channel_layout_from_string(&layout, describe) >= 0) { return 0; }
+
+    std::string lower(describe);
+    for (size_t i = 0; i < lower.size(); i++) { lower[i] = (char)tolower((unsigned char)lower[i]); }
+    if (av_channel_layout_from_string(&layout, lower.c_str()) >= 0) { return 0; }
+
+    std::cerr << "Error: unsupported channel layout " << std::string(describe) << std::endl;
+    return -1;
+}
+
+// 矩阵每行对应一个输出声道，行之间用 '|' 分隔，行内为各输入声道的系数，例如 5.1 -> stereo：
+// "1 0 0.707 0 0.707 0|0 1 0.707 0 0 0.707"
+static int32_t parse_matrix(
+    const char *describe,
+    int32_t in_channels,
+    int32_t out_channels,
+    std::vector<double> &matrix) {
+    matrix.clear();
+    std::stringstream rows(describe);
+    std::string row;
+    while (std::getline(rows, row, '|')) {
+        std::stringstream coefficients(row);
+        double value = 0;
+        int32_t count = 0;
+        while (coefficients >> value) {
+            matrix.push_back(value);
+            count++;
+        }
+        if (count != in_channels) {
+            std::cerr << "Error: matrix row needs " << in_channels << " coefficients: " << row << std::endl;
+            return -1;
+        }
+    }
+    if ((int32_t)matrix.size() != in_channels * out_channels) {
+        std::cerr << "Error: matrix needs " << out_channels << " rows." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+void set_audio_resampler_output(const AudioResamplerOutputCallback &callback) {
+    output_callback = callback;
 }
 
 int32_t init_audio_resampler(
@@ -45,49 +162,24 @@ int32_t init_audio_resampler(
     const char *in_ch_layout,
     int32_t out_sample_rate,
     const char *out_sample_fmt,
-    const char *out_ch_layout) {
+    const char *out_ch_layout,
+    const char *engine,
+    const char *quality,
+    const char *matrix) {
     int32_t result = 0;
-    swr_ctx = swr_alloc();
-    if (!swr_ctx) {
-        std::cerr << "Error: failed to allocate SwrContext." << std::endl;
+    if (parse_ch_layout(in_ch_layout, src_ch_layout) < 0 || parse_ch_layout(out_ch_layout, dst_ch_layout) < 0) {
         return -1;
     }
 
-    int64_t src_ch_layout = -1, dst_ch_layout = -1;
-    if (!strcasecmp(in_ch_layout, "MONO")) {
-        src_ch_layout = AV_CH_LAYOUT_MONO;
-    } else if (!strcasecmp(in_ch_layout, "STEREO")) {
-        src_ch_layout = AV_CH_LAYOUT_STEREO;
-    } else if (!strcasecmp(in_ch_layout, "SURROUND")) {
-        src_ch_layout = AV_CH_LAYOUT_SURROUND;
-    } else {
-        std::cerr << "Error: unsupported input channel layout." << std::endl;
-        return -1;
-    }
-    if (!strcasecmp(out_ch_layout, "MONO")) {
-        dst_ch_layout = AV_CH_LAYOUT_MONO;
-    } else if (!strcasecmp(out_ch_layout, "STEREO")) {
-        dst_ch_layout = AV_CH_LAYOUT_STEREO;
-    } else if (!strcasecmp(out_ch_layout, "SURROUND")) {
-        dst_ch_layout = AV_CH_LAYOUT_SURROUND;
-    } else {
-        std::cerr << "Error: unsupported output channel layout." << std::endl;
-        return -1;
-    }
-
-    if (!strcasecmp(in_sample_fmt, "fltp")) {
-        src_sample_fmt = AV_SAMPLE_FMT_FLTP;
-    } else if (!strcasecmp(in_sample_fmt, "s16")) {
-        src_sample_fmt = AV_SAMPLE_FMT_S16P;
-    } else {
+    // 输入输出文件中的样本都是交错存放的，planar 格式名按对应的 packed 格式处理，
+    // 读写时不需要额外的交错/解交错
+    src_sample_fmt = av_get_packed_sample_fmt(av_get_sample_fmt(in_sample_fmt));
+    if (src_sample_fmt == AV_SAMPLE_FMT_NONE) {
         std::cerr << "Error: unsupported input sample format." << std::endl;
         return -1;
     }
-    if (!strcasecmp(out_sample_fmt, "fltp")) {
-        dst_sample_fmt = AV_SAMPLE_FMT_FLTP;
-    } else if (!strcasecmp(out_sample_fmt, "s16")) {
-        dst_sample_fmt = AV_SAMPLE_FMT_S16P;
-    } else {
+    dst_sample_fmt = av_get_packed_sample_fmt(av_get_sample_fmt(out_sample_fmt));
+    if (dst_sample_fmt == AV_SAMPLE_FMT_NONE) {
         std::cerr << "Error: unsupported output sample format." << std::endl;
         return -1;
     }
@@ -95,95 +187,311 @@ int32_t init_audio_resampler(
     src_rate = in_sample_rate;
     dst_rate = out_sample_rate;
 
-    av_opt_set_int(swr_ctx, "in_channel_layout", src_ch_layout, 0);
-    av_opt_set_int(swr_ctx, "in_sample_rate", src_rate, 0);
-    av_opt_set_sample_fmt(swr_ctx, "in_sample_fmt", src_sample_fmt, 0);
-
-    av_opt_set_int(swr_ctx, "out_channel_layout", dst_ch_layout, 0);
-    av_opt_set_int(swr_ctx, "out_sample_rate", dst_rate, 0);
-    av_opt_set_sample_fmt(swr_ctx, "out_sample_fmt", dst_sample_fmt, 0);
+    result = parse_resampler_engine(engine, quality);
+    if (result < 0) { return result; }
 
-    result = swr_init(swr_ctx);
-    if (result < 0) {
-        std::cerr << "Error: failed to initialize SwrContext." << std::endl;
-        return -1;
+    // 不指定矩阵时由 libswresample 按声道位置生成（中置与环绕 -3dB，丢弃 LFE）；
+    // ambisonics 等非标准顺序的布局之间没有默认矩阵，必须指定
+    matrix_coefficients.clear();
+    if (matrix && matrix[0]) {
+        result = parse_matrix(matrix, src_ch_layout.nb_channels, dst_ch_layout.nb_channels, matrix_coefficients);
+        if (result < 0) { return result; }
     }
 
-    input_frame = av_frame_alloc();
-    if (!input_frame) {
-        std::cerr << "Error: could not alloc input frame." << std::endl;
-        return -1;
-    }
-    result = init_frame(in_sample_rate, src_sample_fmt, src_ch_layout);
-    if (result < 0) {
-        std::cerr << "Error: failed to initialize input frame." << std::endl;
-        return -1;
-    }
-    max_dst_nb_samples = dst_nb_samples = av_rescale_rnd(SRC_NB_SAMPLES, out_sample_rate, in_sample_rate, AV_ROUND_UP);
-    dst_nb_channels = av_get_channel_layout_nb_channels(dst_ch_layout);
-    std::cout << "max_dst_nb_samples:" << max_dst_nb_samples << ", dst_nb_channels : " << dst_nb_channels << std::endl;
+    result = create_swr_context(&swr_ctx);
+    if (result < 0) { return result; }
+
+    src_nb_channels = src_ch_layout.nb_channels;
+    dst_nb_channels = dst_ch_layout.nb_channels;
+    max_dst_nb_samples = dst_nb_samples = 0;
+    input_samples = output_samples = convert_time_us = 0;
+
+    char src_layout_name[64], dst_layout_name[64];
+    av_channel_layout_describe(&src_ch_layout, src_layout_name, sizeof(src_layout_name));
+    av_channel_layout_describe(&dst_ch_layout, dst_layout_name, sizeof(dst_layout_name));
+    std::cout << "engine:" << std::string(engine) << ", quality:" << std::string(quality)
+              << ", layout:" << src_layout_name << " -> " << dst_layout_name << ", dst_nb_channels : " << dst_nb_channels
+              << std::endl;
 
     return result;
 }
 
-static int32_t resampling_frame() {
+// 输出缓冲按需增长，容纳 nb_samples 个输入样本加上重采样器内部缓存的样本
+static int32_t ensure_dst_buffer(int32_t nb_samples) {
     int32_t result = 0;
-    int32_t dst_bufsize = 0;
+    dst_nb_samples = swr_get_out_samples(swr_ctx, nb_samples);
+    if (dst_nb_samples < 0) {
+        std::cerr << "Error: swr_get_out_samples failed." << std::endl;
+        return -1;
+    }
+    if (dst_nb_samples <= max_dst_nb_samples) { return 0; }
 
-    dst_nb_samples = av_rescale_rnd(swr_get_delay(swr_ctx, src_rate) + SRC_NB_SAMPLES, dst_rate, src_rate, AV_ROUND_UP);
-    if (dst_nb_samples > max_dst_nb_samples) {
+    if (dst_data) {
         av_freep(&dst_data[0]);
-        result = av_samples_alloc(dst_data, &dst_linesize, dst_nb_channels, dst_nb_samples, dst_sample_fmt, 1);
-        if (result < 0) {
-            std::cerr << "Error:failed to reallocat dst_data." << std::endl;
-            return -1;
-        }
-        std::cout << "nb_samples exceeds max_dst_nb_samples, buffer reallocated." << std::endl;
-        max_dst_nb_samples = dst_nb_samples;
+        av_freep(&dst_data);
     }
-    result = swr_convert(swr_ctx, dst_data, dst_nb_samples, (const uint8_t **)input_frame->data, SRC_NB_SAMPLES);
+    result = av_samples_alloc_array_and_samples(
+        &dst_data, &dst_linesize, dst_nb_channels, dst_nb_samples, dst_sample_fmt, 0);
     if (result < 0) {
-        std::cerr << "Error:swr_convert failed." << std::endl;
+        std::cerr << "Error: failed to reallocate dst_data." << std::endl;
         return -1;
     }
-    dst_bufsize = av_samples_get_buffer_size(&dst_linesize, dst_nb_channels, result, dst_sample_fmt, 1);
+    max_dst_nb_samples = dst_nb_samples;
+    return 0;
+}
+
+static int32_t write_output(const uint8_t *data, int32_t nb_samples) {
+    output_samples += nb_samples;
+    if (output_callback) { return output_callback(data, nb_samples); }
+
+    int32_t dst_bufsize = av_samples_get_buffer_size(NULL, dst_nb_channels, nb_samples, dst_sample_fmt, 1);
     if (dst_bufsize < 0) {
         std::cerr << "Error:Could not get sample buffer size." << std::endl;
         return -1;
     }
-    write_packed_data_to_file(dst_data[0], dst_bufsize);
-
-    return result;
+    write_packed_data_to_file(data, dst_bufsize);
+    return 0;
 }
 
-int32_t audio_resample() {
-    int32_t result = av_samples_alloc_array_and_samples(
-        &dst_data, &dst_linesize, dst_nb_channels, dst_nb_samples, dst_sample_fmt, 0);
+int32_t resample_samples(const uint8_t *data, int32_t nb_samples) {
+    int32_t result = ensure_dst_buffer(data ? nb_samples : 0);
+    if (result < 0) { return result; }
+
+    auto start = std::chrono::steady_clock::now();
+    const uint8_t *in[1] = {data};
+    if (data) {
+        result = swr_convert(swr_ctx, dst_data, dst_nb_samples, in, nb_samples);
+        input_samples += nb_samples;
+    } else {
+        // 冲刷：取出滤波器延迟中剩余的样本，直到重采样器不再输出
+        result = swr_convert(swr_ctx, dst_data, dst_nb_samples, NULL, 0);
+    }
+    convert_time_us +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
     if (result < 0) {
-        std::cerr << "Error: av_samples_alloc_array_and_samples failed." << std::endl;
+        std::cerr << "Error:swr_convert failed." << std::endl;
         return -1;
     }
-    std::cout << "dst_linesize:" << dst_linesize << std::endl;
+    if (result == 0) { return 0; }
 
+    int32_t converted = result;
+    result = write_output(dst_data[0], converted);
+    if (result < 0) { return result; }
+
+    // 冲刷时一次可能取不完
+    if (!data) { return resample_samples(nullptr, 0); }
+    return converted;
+}
+
+int32_t audio_resample(int32_t chunk_size) {
+    int32_t frame_bytes = av_get_bytes_per_sample(src_sample_fmt) * src_nb_channels;
+    read_buffer.resize((size_t)chunk_size * frame_bytes);
+    read_buffered = 0;
+
+    int32_t result = 0;
     while (!end_of_input_file()) {
-        result = read_pcm_to_frame2(input_frame, src_sample_fmt, 2);
-        if (result < 0) {
-            std::cerr << "Error: read_pcm_to_frame failed." << std::endl;
+        int32_t read_size = 0;
+        if (read_data_to_buf(
+                read_buffer.data() + read_buffered, (int32_t)(read_buffer.size() - read_buffered), read_size)
+            < 0) {
+            if (end_of_input_file()) { break; }
+            std::cerr << "Error: read pcm data failed." << std::endl;
             return -1;
         }
-        result = resampling_frame();
+        read_buffered += read_size;
+
+        // 最后一次读取不足一个块时按实际读到的样本数处理
+        int32_t nb_samples = (int32_t)(read_buffered / frame_bytes);
+        if (nb_samples == 0) { continue; }
+        result = resample_samples(read_buffer.data(), nb_samples);
         if (result < 0) {
-            std::cerr << "Error: resampling_frame failed." << std::endl;
+            std::cerr << "Error: resample_samples failed." << std::endl;
             return -1;
         }
+
+        size_t used = (size_t)nb_samples * frame_bytes;
+        memmove(read_buffer.data(), read_buffer.data() + used, read_buffered - used);
+        read_buffered -= used;
     }
 
-    return result;
+    result = resample_samples(nullptr, 0);
+    if (result < 0) {
+        std::cerr << "Error: flushing resampler failed." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 分块并行重采样
+
+struct ResampleChunk {
+    int64_t start; // 块在输入中的范围 [start, end)，为全局样本序号
+    int64_t end;
+    bool last;
+    std::vector<uint8_t> output;
+    int32_t result;
+};
+
+// 块两侧额外送入的输入样本数，需要覆盖滤波器的半长。swr 的 filter_size 以较低的采样率计，
+// 降采样时按比例拉长；soxr 的滤波器长度不直接暴露，按 200ms 估计，远大于最高精度档位的滤波器
+static int64_t chunk_overlap() {
+    if (use_soxr) { return src_rate / 5; }
+    double stretch = src_rate > dst_rate ? (double)src_rate / dst_rate : 1.0;
+    return (int64_t)(swr_filter_sizes[resampler_level] * stretch) + 16;
+}
+
+// window 中保存全局序号从 base 开始的输入样本。块从 start - overlap 开始送入一个新的重采样器，
+// 起点的输出位置是整数，输出的相位与串行处理完全一致；丢掉两侧只受重叠部分影响的输出
+static void resample_chunk(
+    const uint8_t *window,
+    int64_t base,
+    int64_t available,
+    int64_t overlap,
+    int64_t in_step,
+    int64_t out_step,
+    ResampleChunk &chunk) {
+    int32_t src_frame_bytes = av_get_bytes_per_sample(src_sample_fmt) * src_nb_channels;
+    int32_t dst_frame_bytes = av_get_bytes_per_sample(dst_sample_fmt) * dst_nb_channels;
+    int64_t begin = chunk.start - overlap > base ? chunk.start - overlap : base;
+    int64_t stop = chunk.end + overlap < available ? chunk.end + overlap : available;
+    int32_t nb_input = (int32_t)(stop - begin);
+
+    struct SwrContext *ctx = nullptr;
+    chunk.result = create_swr_context(&ctx);
+    if (chunk.result < 0) {
+        swr_free(&ctx);
+        return;
+    }
+
+    // 整段一次转换，再冲刷出剩余的样本
+    int32_t capacity = swr_get_out_samples(ctx, nb_input);
+    chunk.output.resize((size_t)capacity * dst_frame_bytes);
+    uint8_t *out[1] = {chunk.output.data()};
+    const uint8_t *in[1] = {window + (size_t)(begin - base) * src_frame_bytes};
+    int32_t produced = swr_convert(ctx, out, capacity, in, nb_input);
+    while (produced >= 0) {
+        int32_t remaining = swr_get_out_samples(ctx, 0);
+        if (remaining <= 0) { break; }
+        chunk.output.resize((size_t)(produced + remaining) * dst_frame_bytes);
+        out[0] = chunk.output.data() + (size_t)produced * dst_frame_bytes;
+        int32_t flushed = swr_convert(ctx, out, remaining, NULL, 0);
+        if (flushed <= 0) {
+            if (flushed < 0) { produced = flushed; }
+            break;
+        }
+        produced += flushed;
+    }
+    swr_free(&ctx);
+    if (produced < 0) {
+        std::cerr << "Error: swr_convert failed." << std::endl;
+        chunk.result = -1;
+        return;
+    }
+
+    // begin 与 start 之差是 in_step 的整数倍，对应的输出样本数是整数
+    int64_t skip = (chunk.start - begin) / in_step * out_step;
+    int64_t keep = chunk.last ? produced - skip : (chunk.end - chunk.start) / in_step * out_step;
+    if (skip > produced) { skip = produced; }
+    if (keep > produced - skip) { keep = produced - skip; }
+    memmove(chunk.output.data(), chunk.output.data() + (size_t)skip * dst_frame_bytes, (size_t)keep * dst_frame_bytes);
+    chunk.output.resize((size_t)keep * dst_frame_bytes);
+    chunk.result = 0;
+}
+
+int32_t audio_resample_parallel(int32_t nb_threads, double chunk_seconds) {
+    // 块长与重叠长度取 in_step 的整数倍，in_step:out_step 为约分后的采样率之比
+    int64_t divisor = av_gcd(src_rate, dst_rate);
+    int64_t in_step = src_rate / divisor, out_step = dst_rate / divisor;
+    int64_t chunk_length = (int64_t)(chunk_seconds * src_rate);
+    chunk_length = (chunk_length > in_step ? chunk_length : in_step) + in_step - 1;
+    chunk_length -= chunk_length % in_step;
+    int64_t overlap = (chunk_overlap() + in_step - 1) / in_step * in_step;
+
+    ThreadPool pool(nb_threads);
+    std::vector<ResampleChunk> chunks(pool.size());
+    int32_t frame_bytes = av_get_bytes_per_sample(src_sample_fmt) * src_nb_channels;
+    std::vector<uint8_t> window;
+    size_t window_bytes = 0;
+    int64_t base = 0, next = 0;
+    bool eof = false;
+
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        // 读入这一轮所有块及其右侧重叠需要的输入，窗口中保留上一轮末尾的重叠部分
+        int64_t wanted = next + (int64_t)chunks.size() * chunk_length + overlap;
+        window.resize((size_t)(wanted - base) * frame_bytes + frame_bytes);
+        while (!eof && base + (int64_t)(window_bytes / frame_bytes) < wanted) {
+            int32_t read_size = 0;
+            int32_t space = (int32_t)std::min(window.size() - window_bytes, (size_t)INT32_MAX);
+            if (read_data_to_buf(window.data() + window_bytes, space, read_size) < 0) {
+                if (!end_of_input_file()) {
+                    std::cerr << "Error: read pcm data failed." << std::endl;
+                    return -1;
+                }
+                read_size = 0;
+            }
+            window_bytes += read_size;
+            if (end_of_input_file()) { eof = true; }
+        }
+        int64_t available = base + (int64_t)(window_bytes / frame_bytes);
+
+        int32_t nb_chunks = 0;
+        for (int64_t chunk_start = next; nb_chunks < (int32_t)chunks.size() && chunk_start < available;
+             chunk_start += chunk_length) {
+            ResampleChunk &chunk = chunks[nb_chunks++];
+            chunk.start = chunk_start;
+            chunk.end = chunk_start + chunk_length < available ? chunk_start + chunk_length : available;
+            chunk.last = eof && chunk.end == available;
+            chunk.result = 0;
+            if (chunk.last) { break; }
+        }
+        if (nb_chunks == 0) { break; }
+
+        pool.execute(nb_chunks, [&](int32_t job, int32_t) {
+            resample_chunk(window.data(), base, available, overlap, in_step, out_step, chunks[job]);
+        });
+
+        // 按顺序拼接各块的输出
+        size_t dst_frame_bytes = (size_t)av_get_bytes_per_sample(dst_sample_fmt) * dst_nb_channels;
+        for (int32_t i = 0; i < nb_chunks; i++) {
+            if (chunks[i].result < 0) { return chunks[i].result; }
+            int32_t nb_output = (int32_t)(chunks[i].output.size() / dst_frame_bytes);
+            if (nb_output > 0 && write_output(chunks[i].output.data(), nb_output) < 0) { return -1; }
+            input_samples += chunks[i].end - chunks[i].start;
+        }
+        next = chunks[nb_chunks - 1].end;
+        if (chunks[nb_chunks - 1].last) { break; }
+
+        // 丢掉已经处理过的输入，只保留下一块左侧重叠需要的部分
+        int64_t keep_from = next - overlap > base ? next - overlap : base;
+        size_t dropped = (size_t)(keep_from - base) * frame_bytes;
+        memmove(window.data(), window.data() + dropped, window_bytes - dropped);
+        window_bytes -= dropped;
+        base = keep_from;
+    }
+    convert_time_us +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+void print_audio_resampler_stats() {
+    double seconds = convert_time_us / 1000000.0;
+    std::cout << "Resampler input samples:" << input_samples << ", output samples:" << output_samples
+              << ", convert time:" << convert_time_us / 1000.0 << "ms";
+    if (seconds > 0) { std::cout << ", input samples/s:" << (int64_t)(input_samples / seconds); }
+    std::cout << std::endl;
 }
 
 void destroy_audio_resampler() {
-    av_frame_free(&input_frame);
     if (dst_data) av_freep(&dst_data[0]);
     av_freep(&dst_data);
+    max_dst_nb_samples = dst_nb_samples = 0;
     swr_free(&swr_ctx);
+    av_channel_layout_uninit(&src_ch_layout);
+    av_channel_layout_uninit(&dst_ch_layout);
+    matrix_coefficients.clear();
+    output_callback = nullptr;
+    std::vector<uint8_t>().swap(read_buffer);
+    read_buffered = 0;
 }
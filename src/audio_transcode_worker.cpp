@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+#include <libavutil/samplefmt.h>
+}
+
+#include "audio_transcode_worker.h"
+#include "thread_pool.h"
+
+#define TRANSCODE_PCM_FRAME_SIZE  1024 // 可变帧长编码器（如 PCM）每帧的样本数
+
+AudioTranscodeWorker::~AudioTranscodeWorker() {
+    uninit();
+}
+
+int32_t AudioTranscodeWorker::open_encoder() {
+    avcodec_free_context(&enc_ctx_);
+    enc_ctx_ = avcodec_alloc_context3(encoder_);
+    if (!enc_ctx_) {
+        std::cerr << "Error: could not allocate encoder context." << std::endl;
+        return -1;
+    }
+
+    enc_ctx_->bit_rate = config_.bit_rate;
+    enc_ctx_->sample_rate = config_.sample_rate;
+    enc_ctx_->sample_fmt = encoder_->sample_fmts ? encoder_->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
+    enc_ctx_->time_base = (AVRational){1, config_.sample_rate};
+    if (av_channel_layout_from_string(&enc_ctx_->ch_layout, config_.ch_layout.c_str()) < 0) {
+        std::cerr << "Error: invalid channel layout " << config_.ch_layout << std::endl;
+        return -1;
+    }
+
+    if (avcodec_open2(enc_ctx_, encoder_, nullptr) < 0) {
+        std::cerr << "Error: could not open encoder " << encoder_->name << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t AudioTranscodeWorker::init(const AudioTranscodeConfig &config) {
+    config_ = config;
+    decoder_ = find_audio_codec(config.decoder_name.c_str(), false);
+    encoder_ = find_audio_codec(config.encoder_name.c_str(), true);
+    if (!decoder_ || !encoder_) { return -1; }
+
+    dec_ctx_ = avcodec_alloc_context3(decoder_);
+    if (!dec_ctx_ || avcodec_open2(dec_ctx_, decoder_, nullptr) < 0) {
+        std::cerr << "Error: could not open decoder " << decoder_->name << std::endl;
+        return -1;
+    }
+    if (open_encoder() < 0) { return -1; }
+
+    frame_size_ = enc_ctx_->frame_size > 0 ? enc_ctx_->frame_size : TRANSCODE_PCM_FRAME_SIZE;
+    decoded_frame_ = av_frame_alloc();
+    encode_frame_ = av_frame_alloc();
+    in_packet_ = av_packet_alloc();
+    out_packet_ = av_packet_alloc();
+    fifo_ = av_audio_fifo_alloc(enc_ctx_->sample_fmt, enc_ctx_->ch_layout.nb_channels, frame_size_ * 4);
+    if (!decoded_frame_ || !encode_frame_ || !in_packet_ || !out_packet_ || !fifo_) {
+        std::cerr << "Error: could not allocate transcode buffers." << std::endl;
+        return -1;
+    }
+
+    encode_frame_->nb_samples = frame_size_;
+    encode_frame_->format = enc_ctx_->sample_fmt;
+    encode_frame_->sample_rate = enc_ctx_->sample_rate;
+    if (av_channel_layout_copy(&encode_frame_->ch_layout, &enc_ctx_->ch_layout) < 0
+        || av_frame_get_buffer(encode_frame_, 0) < 0) {
+        std::cerr << "Error: could not allocate encoder frame." << std::endl;
+        return -1;
+    }
+    return fifo_writer_.init(fifo_, &enc_ctx_->ch_layout, enc_ctx_->sample_fmt, enc_ctx_->sample_rate);
+}
+
+void AudioTranscodeWorker::uninit() {
+    av_parser_close(parser_);
+    parser_ = nullptr;
+    avcodec_free_context(&dec_ctx_);
+    avcodec_free_context(&enc_ctx_);
+    fifo_writer_.uninit();
+    if (fifo_) {
+        av_audio_fifo_free(fifo_);
+        fifo_ = nullptr;
+    }
+    av_frame_free(&decoded_frame_);
+    av_frame_free(&encode_frame_);
+    av_packet_free(&in_packet_);
+    av_packet_free(&out_packet_);
+}
+
+// 文件之间重置状态而不释放上下文；编码器不支持 flush 时（多数音频编码器）只能重新打开
+int32_t AudioTranscodeWorker::reset() {
+    avcodec_flush_buffers(dec_ctx_);
+    if (encoder_drained_) {
+        if (encoder_->capabilities & AV_CODEC_CAP_ENCODER_FLUSH) {
+            avcodec_flush_buffers(enc_ctx_);
+        } else if (open_encoder() < 0) {
+            return -1;
+        }
+        encoder_drained_ = false;
+    }
+
+    // 解析器内部缓存着跨读取边界的数据，没有重置接口，重新创建的开销很小
+    av_parser_close(parser_);
+    parser_ = av_parser_init(decoder_->id);
+    if (!parser_) {
+        std::cerr << "Error: no parser for " << decoder_->name << std::endl;
+        return -1;
+    }
+
+    if (fifo_writer_.reset() < 0) { return -1; }
+    av_audio_fifo_reset(fifo_);
+    next_pts_ = 0;
+    return 0;
+}
+
+int32_t AudioTranscodeWorker::encode_frame(const AVFrame *input) {
+    int32_t result = avcodec_send_frame(enc_ctx_, input);
+    if (result < 0) {
+        std::cerr << "Error: could not avcodec_send_frame." << std::endl;
+        return result;
+    }
+
+    while (true) {
+        result = avcodec_receive_packet(enc_ctx_, out_packet_);
+        if (result == AVERROR(EAGAIN) || result == AVERROR_EOF) { return 0; }
+        if (result < 0) {
+            std::cerr << "Error: could not avcodec_receive_packet." << std::endl;
+            return result;
+        }
+        size_t size = out_packet_->size;
+        size_t written = fwrite(out_packet_->data, 1, size, output_);
+        av_packet_unref(out_packet_);
+        if (written != size) { return -1; }
+    }
+}
+
+// 按编码器帧长从 FIFO 取样本编码；flushing 时最后不足一帧的样本作为短帧送入
+int32_t AudioTranscodeWorker::encode_from_fifo(bool flushing) {
+    while (av_audio_fifo_size(fifo_) >= frame_size_ || (flushing && av_audio_fifo_size(fifo_) > 0)) {
+        // 编码器可能仍持有上一帧的引用
+        if (av_frame_make_writable(encode_frame_) < 0) { return -1; }
+        int32_t nb_samples = std::min(av_audio_fifo_size(fifo_), frame_size_);
+        if (av_audio_fifo_read(fifo_, (void **)encode_frame_->data, nb_samples) != nb_samples) { return -1; }
+        encode_frame_->nb_samples = nb_samples;
+        encode_frame_->pts = next_pts_;
+        next_pts_ += nb_samples;
+
+        int32_t result = encode_frame(encode_frame_);
+        encode_frame_->nb_samples = frame_size_;
+        if (result < 0) { return result; }
+    }
+    return 0;
+}
+
+int32_t AudioTranscodeWorker::decode_packet(const AVPacket *packet) {
+    int32_t result = avcodec_send_packet(dec_ctx_, packet);
+    // 损坏的数据包跳过，不中断整个文件
+    if (result < 0 && result != AVERROR_INVALIDDATA) {
+        std::cerr << "Error: cannot send packet to decoder." << std::endl;
+        return result;
+    }
+
+    while (true) {
+        result = avcodec_receive_frame(dec_ctx_, decoded_frame_);
+        if (result == AVERROR(EAGAIN) || result == AVERROR_EOF) { return 0; }
+        if (result < 0) {
+            std::cerr << "Error: cannot receive frame from decoder." << std::endl;
+            return result;
+        }
+        result = fifo_writer_.write_frame(decoded_frame_);
+        av_frame_unref(decoded_frame_);
+        if (result < 0 || (result = encode_from_fifo(false)) < 0) { return result; }
+    }
+}
+
+int32_t AudioTranscodeWorker::transcode(const std::string &input_file, const std::string &output_file) {
+    if (reset() < 0) { return -1; }
+
+    FILE *input = fopen(input_file.c_str(), "rb");
+    output_ = fopen(output_file.c_str(), "wb");
+    if (!input || !output_) {
+        std::cerr << "Error: cannot open " << (input ? output_file : input_file) << std::endl;
+        if (input) { fclose(input); }
+        if (output_) { fclose(output_); }
+        output_ = nullptr;
+        return -1;
+    }
+
+    int32_t result = parse_audio_stream(
+        parser_, dec_ctx_, in_packet_, inbuf_,
+        [input](uint8_t *buf, int32_t size) {
+            size_t read_size = fread(buf, 1, size, input);
+            return read_size == 0 && ferror(input) ? -1 : (int32_t)read_size;
+        },
+        [this](AVPacket *packet) { return decode_packet(packet); });
+
+    // 依次冲刷解码器、重采样器、FIFO 和编码器
+    if (result >= 0) { result = decode_packet(nullptr); }
+    if (result >= 0) { result = fifo_writer_.write(nullptr, 0); }
+    if (result >= 0) { result = encode_from_fifo(true); }
+    if (result >= 0) {
+        encoder_drained_ = true;
+        result = encode_frame(nullptr);
+    }
+
+    fclose(input);
+    if (fclose(output_) != 0 && result >= 0) { result = -1; }
+    output_ = nullptr;
+    return result < 0 ? -1 : 0;
+}
+
+int32_t run_audio_transcode_batch(
+    const AudioTranscodeConfig &config,
+    std::vector<AudioTranscodeJob> &jobs,
+    int32_t nb_workers) {
+    ThreadPool pool(nb_workers);
+    std::vector<std::unique_ptr<AudioTranscodeWorker>> workers(pool.size());
+    for (size_t i = 0; i < workers.size(); i++) { workers[i].reset(new AudioTranscodeWorker()); }
+
+    pool.execute((int32_t)jobs.size(), [&](int32_t job_index, int32_t thread_index) {
+        AudioTranscodeJob &job = jobs[job_index];
+        AudioTranscodeWorker &worker = *workers[thread_index];
+        auto start = std::chrono::steady_clock::now();
+
+        // 编解码器在每个线程第一次取到任务时打开，之后一直复用
+        job.result = worker.initialized() ? 0 : worker.init(config);
+        if (job.result == 0) { job.result = worker.transcode(job.input_file, job.output_file); }
+        if (job.result < 0) {
+            std::cerr << "Error: transcode " << job.input_file << " failed." << std::endl;
+            if (worker.initialized()) { worker.uninit(); }
+        }
+        job.latency_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    });
+
+    int32_t failed = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        if (jobs[i].result < 0) { failed++; }
+    }
+    return failed;
+}
+
+void print_audio_transcode_stats(const std::vector<AudioTranscodeJob> &jobs, int64_t wall_time_us) {
+    if (jobs.empty() || wall_time_us <= 0) { return; }
+
+    std::vector<int64_t> latencies;
+    int64_t total_us = 0;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        latencies.push_back(jobs[i].latency_us);
+        total_us += jobs[i].latency_us;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << "Transcoded files:" << jobs.size() << ", wall time:" << wall_time_us / 1000.0
+              << "ms, throughput:" << jobs.size() * 1e6 / wall_time_us << " files/s" << std::endl;
+    std::cout << "Per-file latency avg:" << total_us / 1000.0 / jobs.size()
+              << "ms, p50:" << latencies[latencies.size() / 2] / 1000.0
+              << "ms, p95:" << latencies[latencies.size() * 95 / 100] / 1000.0
+              << "ms, max:" << latencies.back() / 1000.0 << "ms" << std::endl;
+}
@@ -1,14 +1,18 @@
 extern "C" {
+#include <libavcodec/bsf.h>
 #include <libavformat/avformat.h>
 #include <libavutil/imgutils.h>
 #include <libavutil/samplefmt.h>
 #include <libavutil/timestamp.h>
 }
 
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 #include "demuxer_core.h"
 #include "io_data.h"
+#include "packet_queue.h"
 
 static AVFormatContext *format_ctx = nullptr;
 static AVCodecContext *video_dec_ctx = nullptr, *audio_dec_ctx = nullptr;
@@ -18,9 +22,31 @@ static int video_stream_index = -1, audio_stream_index = -1;
 static AVStream *video_stream = nullptr, *audio_stream = nullptr;
 
 static FILE *output_video_file = nullptr, *output_audio_file = nullptr;
-static AVFrame *frame = nullptr;
+static AVFrame *video_frame = nullptr, *audio_frame = nullptr;
 static AVPacket pkt;
 
+// 解码模式下每路流一个解码线程，解复用线程按流把包放入各自的有界队列。
+// 4K 视频的包大，按字节限制；音频包小，按包数限制
+#define VIDEO_QUEUE_PACKETS 64
+#define AUDIO_QUEUE_PACKETS 256
+#define QUEUE_MAX_BYTES (32 << 20)
+
+static PacketQueue video_queue, audio_queue;
+static int32_t video_decode_result = 0, audio_decode_result = 0;
+static int64_t video_frames = 0, audio_frames = 0;
+
+// 流复制模式：不解码，直接写出压缩的基本流
+#define COPY_IO_BUFFER_SIZE (1 << 20)
+#define ADTS_HEADER_SIZE 7
+
+static bool stream_copy = false;
+static AVBSFContext *video_bsf = nullptr;
+// MP4 中的 AAC 帧没有同步头，按 AudioSpecificConfig 补上 ADTS 头
+static bool audio_need_adts = false;
+static int32_t adts_profile = 0, adts_sample_index = 0, adts_channels = 0;
+static int64_t video_bytes = 0, audio_bytes = 0;
+static int64_t video_packets = 0, audio_packets = 0;
+
 static int open_codec_context(
     int32_t *stream_idx,
     AVCodecContext **decode_ctx,
@@ -76,15 +102,13 @@ static int open_codec_context(
 }
 
 static int32_t write_frame_to_yuv1(AVFrame *frame) {
-    uint8_t **pbuf = frame->data;
-    int *pstride = frame->linesize;
-
     for (size_t i = 0; i < 3; ++i) {
+        const uint8_t *pbuf = frame->data[i];
         int32_t width = (i == 0 ? frame->width : frame->width / 2);
         int32_t height = (i == 0 ? frame->height : frame->height / 2);
         for (size_t j = 0; j < height; ++j) {
-            fwrite(pbuf[i], 1, width, output_audio_file);
-            pbuf[i] += pstride[i];
+            fwrite(pbuf, 1, width, output_video_file);
+            pbuf += frame->linesize[i];
         }
     }
 
@@ -110,7 +134,9 @@ write_samples_to_pcm1(AVFrame *frame, AVCodecContext *codec_ctx) {
     return 0;
 }
 
-static int32_t decode_packet(AVCodecContext *decode_ctx, const AVPacket *pkt) {
+// 由各自的解码线程调用，每路流使用自己的 frame 与输出文件
+static int32_t
+decode_packet(AVCodecContext *decode_ctx, const AVPacket *pkt, AVFrame *frame) {
     int32_t result = 0;
 
     result = avcodec_send_packet(decode_ctx, pkt);
@@ -130,12 +156,13 @@ static int32_t decode_packet(AVCodecContext *decode_ctx, const AVPacket *pkt) {
             return result;
         }
 
+        // 两个线程同时输出逐帧日志会交错在一起，只在结束时汇总帧数
         if (decode_ctx->codec->type == AVMEDIA_TYPE_VIDEO) {
             write_frame_to_yuv1(frame);
-            std::cout << "Write frame to yuv file" << std::endl;
+            video_frames++;
         } else {
             write_samples_to_pcm1(frame, audio_dec_ctx);
-            std::cout << "Write sample to pcm file" << std::endl;
+            audio_frames++;
         }
 
         av_frame_unref(frame);
@@ -175,10 +202,198 @@ get_format_from_sample_fmt(const char **fmt, enum AVSampleFormat sample_fmt) {
     return -1;
 }
 
-int32_t init_demuxer(
+static int32_t read_bits(const uint8_t *buf, int32_t &pos, int32_t nb_bits) {
+    int32_t value = 0;
+    for (int32_t i = 0; i < nb_bits; i++, pos++) {
+        value = (value << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+    }
+    return value;
+}
+
+// 从 extradata 中的 AudioSpecificConfig 取出 ADTS 头需要的字段。
+// HE-AAC 的显式 SBR 信令按核心层的 AAC-LC 写出，解码器会隐式识别 SBR
+static int32_t parse_audio_specific_config(const AVCodecParameters *par) {
+    if (!par->extradata || par->extradata_size < 2) {
+        std::cerr << "Error: AAC stream has no AudioSpecificConfig."
+                  << std::endl;
+        return -1;
+    }
+
+    const uint8_t *config = par->extradata;
+    int32_t bits = par->extradata_size * 8;
+    int32_t pos = 0;
+    int32_t object_type = read_bits(config, pos, 5);
+    if (object_type == 31) { object_type = 32 + read_bits(config, pos, 6); }
+    adts_sample_index = read_bits(config, pos, 4);
+    if (adts_sample_index == 15) {
+        std::cerr << "Error: explicit AAC sample rate is not allowed in ADTS."
+                  << std::endl;
+        return -1;
+    }
+    adts_channels = read_bits(config, pos, 4);
+    if ((object_type == 5 || object_type == 29) && pos + 9 <= bits) {
+        // ADTS 中保留核心层的采样率，扩展层的采样率只跳过
+        int32_t extension_sample_index = read_bits(config, pos, 4);
+        if (extension_sample_index == 15) { pos += 24; }
+        if (pos + 5 > bits) {
+            std::cerr << "Error: truncated AudioSpecificConfig." << std::endl;
+            return -1;
+        }
+        object_type = read_bits(config, pos, 5);
+    }
+
+    // ADTS 的 profile 只有 2 位，对应 AAC Main/LC/SSR/LTP；
+    // 声道配置 0 需要额外写出 PCE，这里不支持
+    if (object_type < 1 || object_type > 4 || adts_channels == 0
+        || adts_channels > 7 || adts_sample_index > 12) {
+        std::cerr << "Error: AAC object type " << object_type
+                  << " with channel config " << adts_channels
+                  << " can not be written as ADTS." << std::endl;
+        return -1;
+    }
+    adts_profile = object_type - 1;
+    return 0;
+}
+
+static void write_adts_header(int32_t payload_size, FILE *output) {
+    int32_t frame_length = payload_size + ADTS_HEADER_SIZE;
+    uint8_t header[ADTS_HEADER_SIZE];
+    header[0] = 0xFF; // syncword
+    header[1] = 0xF1; // MPEG-4，无 CRC
+    header[2] = (uint8_t)(
+        (adts_profile << 6) | (adts_sample_index << 2) | (adts_channels >> 2));
+    header[3] = (uint8_t)(((adts_channels & 3) << 6) | (frame_length >> 11));
+    header[4] = (uint8_t)((frame_length >> 3) & 0xFF);
+    header[5] = (uint8_t)(((frame_length & 7) << 5) | 0x1F); // 码率可变
+    header[6] = 0xFC;
+    fwrite(header, 1, ADTS_HEADER_SIZE, output);
+}
+
+// 按编码格式决定写出方式：H.264/HEVC 转为 Annex B（输入已经是 Annex B 时
+// 滤镜直接透传），AAC 补 ADTS 头，MP3/AC-3/E-AC-3 本身带帧头，原样写出
+static int32_t open_copy_stream(
+    int32_t *stream_idx,
+    AVFormatContext *fmt_ctx,
+    enum AVMediaType type) {
+    int32_t result = av_find_best_stream(fmt_ctx, type, -1, -1, nullptr, 0);
+    if (result < 0) {
+        std::cout << "No " << std::string(av_get_media_type_string(type))
+                  << " stream in input file." << std::endl;
+        return 0;
+    }
+
+    AVStream *st = fmt_ctx->streams[result];
+    enum AVCodecID codec_id = st->codecpar->codec_id;
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        const char *bsf_name = nullptr;
+        if (codec_id == AV_CODEC_ID_H264) {
+            bsf_name = "h264_mp4toannexb";
+        } else if (codec_id == AV_CODEC_ID_HEVC) {
+            bsf_name = "hevc_mp4toannexb";
+        } else {
+            std::cerr << "Error: stream copy does not support video codec "
+                      << std::string(avcodec_get_name(codec_id)) << std::endl;
+            return -1;
+        }
+
+        const AVBitStreamFilter *filter = av_bsf_get_by_name(bsf_name);
+        if (!filter || av_bsf_alloc(filter, &video_bsf) < 0) {
+            std::cerr << "Error: failed to alloc bitstream filter "
+                      << std::string(bsf_name) << std::endl;
+            return -1;
+        }
+        result = avcodec_parameters_copy(video_bsf->par_in, st->codecpar);
+        if (result < 0) { return result; }
+        video_bsf->time_base_in = st->time_base;
+        result = av_bsf_init(video_bsf);
+        if (result < 0) {
+            std::cerr << "Error: av_bsf_init failed." << std::endl;
+            return result;
+        }
+    } else if (codec_id == AV_CODEC_ID_AAC) {
+        // 没有 extradata 的 AAC（如 TS、ADTS 输入）的包自带 ADTS 头
+        audio_need_adts = st->codecpar->extradata_size > 0;
+        if (audio_need_adts) {
+            result = parse_audio_specific_config(st->codecpar);
+            if (result < 0) { return result; }
+        }
+    } else if (
+        codec_id != AV_CODEC_ID_MP3 && codec_id != AV_CODEC_ID_AC3
+        && codec_id != AV_CODEC_ID_EAC3) {
+        std::cerr << "Error: stream copy does not support audio codec "
+                  << std::string(avcodec_get_name(codec_id)) << std::endl;
+        return -1;
+    }
+
+    *stream_idx = st->index;
+    return 0;
+}
+
+static FILE *open_copy_output(const char *name) {
+    FILE *file = fopen(name, "wb");
+    if (file) { setvbuf(file, nullptr, _IOFBF, COPY_IO_BUFFER_SIZE); }
+    return file;
+}
+
+static int32_t init_stream_copy(
     const char *input_name,
     const char *video_output,
     const char *audio_output) {
+    int32_t result = open_copy_stream(
+        &video_stream_index, format_ctx, AVMEDIA_TYPE_VIDEO);
+    if (result < 0) { return result; }
+    result = open_copy_stream(
+        &audio_stream_index, format_ctx, AVMEDIA_TYPE_AUDIO);
+    if (result < 0) { return result; }
+    if (video_stream_index < 0 && audio_stream_index < 0) {
+        std::cerr << "Error: Could not find audio or video stream in the "
+                     "input, aborting "
+                  << std::endl;
+        return -1;
+    }
+
+    // 其余的流不读
+    for (unsigned int i = 0; i < format_ctx->nb_streams; i++) {
+        if ((int32_t)i != video_stream_index
+            && (int32_t)i != audio_stream_index) {
+            format_ctx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    if (video_stream_index >= 0) {
+        video_stream = format_ctx->streams[video_stream_index];
+        output_video_file = open_copy_output(video_output);
+        if (!output_video_file) {
+            std::cerr << "Error: failed to open video output file."
+                      << std::endl;
+            return -1;
+        }
+        std::cout << "Copying video from file " << std::string(input_name)
+                  << " into " << std::string(video_output) << std::endl;
+    }
+    if (audio_stream_index >= 0) {
+        audio_stream = format_ctx->streams[audio_stream_index];
+        output_audio_file = open_copy_output(audio_output);
+        if (!output_audio_file) {
+            std::cerr << "Error: failed to open audio output file."
+                      << std::endl;
+            return -1;
+        }
+        std::cout << "Copying audio from file " << std::string(input_name)
+                  << " into " << std::string(audio_output) << std::endl;
+    }
+
+    av_init_packet(&pkt);
+    pkt.data = nullptr;
+    pkt.size = 0;
+    return 0;
+}
+
+int32_t init_demuxer(
+    const char *input_name,
+    const char *video_output,
+    const char *audio_output,
+    bool copy) {
     int32_t result =
         avformat_open_input(&format_ctx, input_name, nullptr, nullptr);
     if (result < 0) {
@@ -192,6 +407,12 @@ int32_t init_demuxer(
         return result;
     }
 
+    stream_copy = copy;
+    if (stream_copy) {
+        av_dump_format(format_ctx, 0, input_name, 0);
+        return init_stream_copy(input_name, video_output, audio_output);
+    }
+
     // video context
     result = open_codec_context(
         &video_stream_index, &video_dec_ctx, format_ctx, AVMEDIA_TYPE_VIDEO);
@@ -236,12 +457,18 @@ int32_t init_demuxer(
     pkt.data = nullptr;
     pkt.size = 0;
 
-    frame = av_frame_alloc();
-    if (!frame) {
+    video_frame = av_frame_alloc();
+    audio_frame = av_frame_alloc();
+    if (!video_frame || !audio_frame) {
         std::cerr << "Error: Failed to alloc frame." << std::endl;
         return -1;
     }
 
+    result = video_queue.init(VIDEO_QUEUE_PACKETS, QUEUE_MAX_BYTES);
+    if (result < 0) { return result; }
+    result = audio_queue.init(AUDIO_QUEUE_PACKETS, QUEUE_MAX_BYTES);
+    if (result < 0) { return result; }
+
     if (video_stream) {
         std::cout << "Demuxing video from file " << std::string(input_name)
                   << " into " << std::string(video_output) << std::endl;
@@ -254,26 +481,151 @@ int32_t init_demuxer(
     return 0;
 }
 
+static int32_t write_video_packets(AVPacket *packet) {
+    int32_t result = av_bsf_send_packet(video_bsf, packet);
+    if (result < 0) {
+        std::cerr << "Error: av_bsf_send_packet failed." << std::endl;
+        return result;
+    }
+    while ((result = av_bsf_receive_packet(video_bsf, &pkt)) >= 0) {
+        fwrite(pkt.data, 1, pkt.size, output_video_file);
+        video_bytes += pkt.size;
+        video_packets++;
+        av_packet_unref(&pkt);
+    }
+    if (result == AVERROR(EAGAIN) || result == AVERROR_EOF) { return 0; }
+    std::cerr << "Error: av_bsf_receive_packet failed." << std::endl;
+    return result;
+}
+
+static void write_audio_packet(const AVPacket *packet) {
+    if (audio_need_adts) {
+        write_adts_header(packet->size, output_audio_file);
+        audio_bytes += ADTS_HEADER_SIZE;
+    }
+    fwrite(packet->data, 1, packet->size, output_audio_file);
+    audio_bytes += packet->size;
+    audio_packets++;
+}
+
+static int32_t demuxing_copy() {
+    int32_t result = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    // 逐包输出日志会拖慢到远低于 I/O 的速度，只在结束时汇总
+    while ((result = av_read_frame(format_ctx, &pkt)) >= 0) {
+        if (pkt.stream_index == video_stream_index) {
+            // 滤镜取走包的引用，pkt 交回时为空
+            result = write_video_packets(&pkt);
+        } else if (pkt.stream_index == audio_stream_index) {
+            if (audio_need_adts
+                && pkt.size + ADTS_HEADER_SIZE > 0x1FFF) {
+                std::cerr << "Error: AAC frame too large for ADTS."
+                          << std::endl;
+                result = -1;
+            } else {
+                write_audio_packet(&pkt);
+            }
+        }
+        av_packet_unref(&pkt);
+        if (result < 0) { return result; }
+    }
+    if (result != AVERROR_EOF) {
+        std::cerr << "Error: av_read_frame failed:"
+                  << std::string(av_err2str(result)) << std::endl;
+        return result;
+    }
+    if (video_bsf) {
+        result = write_video_packets(nullptr);
+        if (result < 0) { return result; }
+    }
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    std::cout << "Stream copy succeeded, video packets:" << video_packets
+              << ", video bytes:" << video_bytes
+              << ", audio packets:" << audio_packets
+              << ", audio bytes:" << audio_bytes << ", time:" << seconds
+              << "s";
+    if (seconds > 0) {
+        std::cout << ", " << (video_bytes + audio_bytes) / seconds / 1e6
+                  << "MB/s";
+    }
+    std::cout << std::endl;
+    return 0;
+}
+
+// 取空队列后冲刷解码器。出错时 abort 两路队列：另一路解码线程的 pop
+// 立即返回，解复用线程下一次 push 任一路时失败退出
+static void decode_thread(
+    AVCodecContext *decode_ctx,
+    PacketQueue *queue,
+    PacketQueue *other_queue,
+    AVFrame *frame,
+    int32_t *decode_result) {
+    AVPacket *packet = av_packet_alloc();
+    int32_t result = packet ? 0 : AVERROR(ENOMEM);
+    while (result >= 0 && (result = queue->pop(packet)) >= 0) {
+        result = decode_packet(decode_ctx, packet, frame);
+        av_packet_unref(packet);
+    }
+    if (result == AVERROR_EOF) {
+        result = decode_packet(decode_ctx, nullptr, frame);
+    }
+    if (result < 0) {
+        queue->abort();
+        other_queue->abort();
+    }
+    av_packet_free(&packet);
+    *decode_result = result;
+}
+
 int32_t demuxing(const char *video_output_name, const char *audio_output_name) {
     int32_t result = 0;
+    if (stream_copy) { return demuxing_copy(); }
+
+    std::thread video_thread(
+        decode_thread, video_dec_ctx, &video_queue, &audio_queue, video_frame,
+        &video_decode_result);
+    std::thread audio_thread(
+        decode_thread, audio_dec_ctx, &audio_queue, &video_queue, audio_frame,
+        &audio_decode_result);
 
+    // 队列满时 push 阻塞，解复用的速度受较慢的一路解码限制
     while (av_read_frame(format_ctx, &pkt) >= 0) {
-        std::cout << "Read packet, pts:" << pkt.pts
-                  << ", stream:" << pkt.stream_index << ", size:" << pkt.size
-                  << std::endl;
         if (pkt.stream_index == audio_stream_index) {
-            result = decode_packet(audio_dec_ctx, &pkt);
+            result = audio_queue.push(&pkt);
         } else if (pkt.stream_index == video_stream_index) {
-            result = decode_packet(video_dec_ctx, &pkt);
+            result = video_queue.push(&pkt);
         }
         av_packet_unref(&pkt);
         if (result < 0) { break; }
     }
 
-    if (video_dec_ctx) decode_packet(video_dec_ctx, nullptr);
-    if (audio_dec_ctx) decode_packet(audio_dec_ctx, nullptr);
+    // 一路解码出错时另一路也停止，否则正常取空队列并冲刷解码器
+    if (result < 0) {
+        video_queue.abort();
+        audio_queue.abort();
+    } else {
+        video_queue.finish();
+        audio_queue.finish();
+    }
+    video_thread.join();
+    audio_thread.join();
+    if (video_decode_result < 0 && video_decode_result != AVERROR_EXIT) {
+        result = video_decode_result;
+    } else if (
+        audio_decode_result < 0 && audio_decode_result != AVERROR_EXIT) {
+        result = audio_decode_result;
+    }
+    if (result < 0) {
+        std::cerr << "Error: Demuxing failed." << std::endl;
+        return result;
+    }
 
-    std::cout << "Demuxing succeeded." << std::endl;
+    std::cout << "Demuxing succeeded, video frames:" << video_frames
+              << ", audio frames:" << audio_frames << std::endl;
     if (video_dec_ctx) {
         std::cout << "Play the output video file with the command:" << std::endl
                   << "   ffplay -f rawvideo -pix_fmt "
@@ -303,6 +655,17 @@ int32_t demuxing(const char *video_output_name, const char *audio_output_name) {
 }
 
 void destroy_demuxer() {
+    av_bsf_free(&video_bsf);
+    stream_copy = audio_need_adts = false;
+    video_stream_index = audio_stream_index = -1;
+    video_stream = audio_stream = nullptr;
+    video_bytes = audio_bytes = video_packets = audio_packets = 0;
+    av_frame_free(&video_frame);
+    av_frame_free(&audio_frame);
+    video_queue.uninit();
+    audio_queue.uninit();
+    video_decode_result = audio_decode_result = 0;
+    video_frames = audio_frames = 0;
     avcodec_free_context(&video_dec_ctx);
     avcodec_free_context(&audio_dec_ctx);
     avformat_close_input(&format_ctx);
@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+extern "C" {
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavutil/frame.h>
+}
+
+#include "filter_graph_cache.h"
+
+namespace {
+
+struct FilterGraphCacheEntry {
+    std::string key;
+    FilterGraphInstance instance;
+};
+
+typedef std::list<FilterGraphCacheEntry> FilterGraphCacheList;
+
+} // namespace
+
+static std::mutex cache_mutex;
+static FilterGraphCacheList idle_list; // 头部为最近使用
+static std::unordered_multimap<std::string, FilterGraphCacheList::iterator> idle_index;
+static size_t cache_capacity = 8;
+static FilterGraphCacheStats cache_stats = {0, 0, 0, 0, 0, 0, 0};
+
+// 每一帧的输出只取决于这一帧的滤镜，输入帧送入后即可取到对应的输出，没有需要 EOF 冲刷的缓存。
+// scale 包括格式协商时自动插入的 auto_scale
+static const char *stateless_filters[] = {
+    "buffer", "buffersink", "null", "copy", "format", "scale", "crop", "pad", "hflip", "vflip", "transpose",
+    "setsar", "setdar", "split", "drawbox", "drawgrid", "lut", "lutyuv", "lutrgb", "negate", "eq",
+    "colorchannelmixer", "boxblur", "unsharp",
+};
+
+static bool is_stateless_filter(const char *name) {
+    for (size_t i = 0; i < sizeof(stateless_filters) / sizeof(stateless_filters[0]); i++) {
+        if (!strcmp(name, stateless_filters[i])) { return true; }
+    }
+    return false;
+}
+
+bool is_filter_graph_reusable(const AVFilterGraph *graph) {
+    if (!graph) { return false; }
+    for (unsigned int i = 0; i < graph->nb_filters; i++) {
+        if (!is_stateless_filter(graph->filters[i]->filter->name)) { return false; }
+    }
+    return true;
+}
+
+static void free_instance(FilterGraphInstance &instance) {
+    avfilter_graph_free(&instance.graph);
+    instance.src_ctx = nullptr;
+    instance.sink_ctxs.clear();
+}
+
+static void remove_idle_entry(FilterGraphCacheList::iterator entry) {
+    auto range = idle_index.equal_range(entry->key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == entry) {
+            idle_index.erase(it);
+            break;
+        }
+    }
+    idle_list.erase(entry);
+}
+
+static void evict_over_capacity() {
+    while (idle_list.size() > cache_capacity) {
+        free_instance(idle_list.back().instance);
+        remove_idle_entry(std::prev(idle_list.end()));
+        cache_stats.evictions++;
+    }
+}
+
+int32_t acquire_filter_graph(const std::string &key, const FilterGraphBuilder &builder, FilterGraphInstance &instance) {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto found = idle_index.find(key);
+        if (found != idle_index.end()) {
+            instance = found->second->instance;
+            idle_list.erase(found->second);
+            idle_index.erase(found);
+            cache_stats.hits++;
+            return 0;
+        }
+        cache_stats.misses++;
+    }
+
+    // 解析与格式协商放在锁外进行
+    instance.graph = nullptr;
+    instance.src_ctx = nullptr;
+    instance.sink_ctxs.clear();
+    auto start = std::chrono::steady_clock::now();
+    int32_t result = builder(instance);
+    int64_t elapsed_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_stats.build_time_us += elapsed_us;
+    if (elapsed_us > cache_stats.max_build_time_us) { cache_stats.max_build_time_us = elapsed_us; }
+    if (result < 0) {
+        std::cerr << "Error: failed to build filter graph." << std::endl;
+        free_instance(instance);
+    }
+    return result;
+}
+
+void release_filter_graph(const std::string &key, FilterGraphInstance &instance, bool reusable) {
+    if (!instance.graph) { return; }
+    reusable = reusable && is_filter_graph_reusable(instance.graph);
+
+    // 取空输出端残留的帧，避免下一个任务收到上一个任务的数据
+    AVFrame *frame = av_frame_alloc();
+    for (size_t i = 0; frame && reusable && i < instance.sink_ctxs.size(); i++) {
+        int32_t result = 0;
+        while ((result = av_buffersink_get_frame(instance.sink_ctxs[i], frame)) >= 0) { av_frame_unref(frame); }
+        if (result != AVERROR(EAGAIN)) { reusable = false; }
+    }
+    av_frame_free(&frame);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (!reusable) {
+        free_instance(instance);
+        cache_stats.discards++;
+        return;
+    }
+
+    FilterGraphCacheEntry entry = {key, instance};
+    idle_list.push_front(entry);
+    idle_index.insert(std::make_pair(key, idle_list.begin()));
+    instance.graph = nullptr;
+    instance.src_ctx = nullptr;
+    instance.sink_ctxs.clear();
+    evict_over_capacity();
+}
+
+void set_filter_graph_cache_capacity(int32_t capacity) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_capacity = capacity > 0 ? capacity : 1;
+    evict_over_capacity();
+}
+
+void get_filter_graph_cache_stats(FilterGraphCacheStats &stats) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    stats = cache_stats;
+    stats.idle = (int32_t)idle_list.size();
+}
+
+void print_filter_graph_cache_stats() {
+    FilterGraphCacheStats stats;
+    get_filter_graph_cache_stats(stats);
+    std::cout << "Filter graph cache hits:" << stats.hits << ", misses:" << stats.misses
+              << ", evictions:" << stats.evictions << ", discards:" << stats.discards
+              << ", build time:" << stats.build_time_us / 1000.0 << "ms (max " << stats.max_build_time_us / 1000.0
+              << "ms), idle:" << stats.idle << std::endl;
+}
+
+void clear_filter_graph_cache() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (auto it = idle_list.begin(); it != idle_list.end(); ++it) { free_instance(it->instance); }
+    idle_list.clear();
+    idle_index.clear();
+}
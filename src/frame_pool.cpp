@@ -0,0 +1,111 @@
+#include <iostream>
+
+#include "frame_pool.h"
+
+FramePool::~FramePool() {
+    uninit();
+}
+
+int32_t FramePool::alloc_frame() {
+    AVFrame *frame = av_frame_alloc();
+    if (!frame) {
+        std::cerr << "Error: frame allocation failed." << std::endl;
+        return -1;
+    }
+
+    frame->width = template_->width;
+    frame->height = template_->height;
+    frame->nb_samples = template_->nb_samples;
+    frame->format = template_->format;
+    frame->sample_rate = template_->sample_rate;
+    if (av_channel_layout_copy(&frame->ch_layout, &template_->ch_layout) < 0
+        || av_frame_get_buffer(frame, align_) < 0) {
+        std::cerr << "Error: could not get pooled frame buffer." << std::endl;
+        av_frame_free(&frame);
+        return -1;
+    }
+
+    frames_.push_back(frame);
+    return 0;
+}
+
+int32_t FramePool::init(const AVFrame *frame_template, int32_t depth, int32_t align) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (template_) {
+        std::cerr << "Error: frame pool already initialized." << std::endl;
+        return -1;
+    }
+
+    template_ = av_frame_alloc();
+    if (!template_) {
+        std::cerr << "Error: frame allocation failed." << std::endl;
+        return -1;
+    }
+    template_->width = frame_template->width;
+    template_->height = frame_template->height;
+    template_->nb_samples = frame_template->nb_samples;
+    template_->format = frame_template->format;
+    template_->sample_rate = frame_template->sample_rate;
+    if (av_channel_layout_copy(&template_->ch_layout, &frame_template->ch_layout) < 0) {
+        std::cerr << "Error: could not copy channel layout." << std::endl;
+        return -1;
+    }
+    align_ = align;
+
+    for (int32_t i = 0; i < depth; i++) {
+        if (alloc_frame() < 0) { return -1; }
+    }
+    return 0;
+}
+
+void FramePool::uninit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 仍被下游持有的缓冲区由引用计数保证在最后一个引用释放时才回收
+    for (size_t i = 0; i < frames_.size(); i++) { av_frame_free(&frames_[i]); }
+    frames_.clear();
+    av_frame_free(&template_);
+    next_ = 0;
+}
+
+int32_t FramePool::get_frame(AVFrame *dst) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!template_) {
+        std::cerr << "Error: frame pool is not initialized." << std::endl;
+        return -1;
+    }
+
+    // 从上次借出的位置开始轮询，只有池自身持有引用的帧才是空闲的
+    AVFrame *free_frame = nullptr;
+    for (size_t i = 0; i < frames_.size(); i++) {
+        AVFrame *frame = frames_[(next_ + i) % frames_.size()];
+        if (av_frame_is_writable(frame)) {
+            free_frame = frame;
+            next_ = (next_ + i + 1) % frames_.size();
+            break;
+        }
+    }
+
+    if (!free_frame) {
+        if (alloc_frame() < 0) { return -1; }
+        free_frame = frames_.back();
+        next_ = 0;
+        std::cout << "Frame pool exhausted, grown to " << frames_.size() << " frames." << std::endl;
+    }
+
+    av_frame_unref(dst);
+    return av_frame_ref(dst, free_frame);
+}
+
+int32_t FramePool::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int32_t)frames_.size();
+}
+
+int32_t FramePool::available() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int32_t count = 0;
+    for (size_t i = 0; i < frames_.size(); i++) {
+        if (av_frame_is_writable(frames_[i])) { count++; }
+    }
+    return count;
+}
@@ -5,6 +5,11 @@
 #include <iostream>
 #include <sys/types.h>
 
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
 #include "io_data.h"
 
 static FILE *input_file = nullptr;
@@ -34,6 +39,23 @@ int32_t open_input_output_files(const char *input_name, const char *output_name)
     return 0;
 }
 
+int32_t open_input_file(const char *input_name) {
+    if (strlen(input_name) == 0) {
+        std::cerr << "Error: empty input file." << std::endl;
+        return -1;
+    }
+
+    close_input_output_files();
+
+    input_file = fopen(input_name, "rb");
+    if (input_file == nullptr) {
+        std::cerr << "Error: cannot open input file." << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
+
 void close_input_output_files() {
     if (input_file != nullptr) {
         fclose(input_file);
@@ -127,6 +149,11 @@ int32_t write_samples_to_pcm(AVFrame *frame, AVCodecContext *codec_ctx) {
 
     int nb_samples = frame->nb_samples;
     int nb_channels = codec_ctx->ch_layout.nb_channels;
+    // 交错格式（如 FLAC 解码输出的 s16/s32）的所有声道都在 data[0] 中
+    if (!av_sample_fmt_is_planar(codec_ctx->sample_fmt)) {
+        fwrite(frame->data[0], 1, (size_t)data_size * nb_samples * nb_channels, output_file);
+        return 0;
+    }
     for (int i = 0; i < nb_samples; ++i) {
         for (int ch = 0; ch < nb_channels; ++ch) { fwrite(frame->data[ch] + data_size * i, 1, data_size, output_file); }
     }
@@ -157,6 +184,10 @@ int32_t write_samples_to_pcm2(AVFrame *frame, enum AVSampleFormat format, int ch
         std::cerr << "Failed to calculate data size" << std::endl;
         exit(1);
     }
+    if (!av_sample_fmt_is_planar(format)) {
+        fwrite(frame->data[0], 1, (size_t)data_size * frame->nb_samples * channels, output_file);
+        return 0;
+    }
     for (int i = 0; i < frame->nb_samples; i++) {
         for (int ch = 0; ch < channels; ch++) { fwrite(frame->data[ch] + data_size * i, 1, data_size, output_file); }
     }
@@ -181,4 +212,33 @@ int32_t read_pcm_to_frame2(AVFrame *frame, enum AVSampleFormat format, int chann
 
 void write_packed_data_to_file(const uint8_t *buf, int32_t size) {
     fwrite(buf, 1, size, output_file);
+}
+// 按像素格式逐平面、逐行写出任意格式的图像，跳过每行末尾的对齐填充，不需要中间拷贝
+int32_t write_image_to_file(const AVFrame *frame) {
+    enum AVPixelFormat pix_fmt = (enum AVPixelFormat)frame->format;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+    if (!desc) {
+        std::cerr << "Error: unknown pixel format." << std::endl;
+        return -1;
+    }
+
+    int32_t nb_planes = av_pix_fmt_count_planes(pix_fmt);
+    for (int32_t plane = 0; plane < nb_planes; plane++) {
+        int32_t bytes_per_line = av_image_get_linesize(pix_fmt, frame->width, plane);
+        int32_t height = frame->height;
+        if ((plane == 1 || plane == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB)) {
+            height = -((-height) >> desc->log2_chroma_h);
+        }
+        if (bytes_per_line < 0) {
+            std::cerr << "Error: invalid plane line size." << std::endl;
+            return -1;
+        }
+
+        const uint8_t *row = frame->data[plane];
+        for (int32_t y = 0; y < height; y++) {
+            fwrite(row, 1, bytes_per_line, output_file);
+            row += frame->linesize[plane];
+        }
+    }
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include <iostream>
+
+#include "packet_queue.h"
+
+PacketQueue::~PacketQueue() {
+    uninit();
+}
+
+int32_t PacketQueue::init(int32_t max_packets, int64_t max_bytes) {
+    uninit();
+    if (max_packets <= 0 || max_bytes <= 0) {
+        std::cerr << "Error: invalid packet queue size." << std::endl;
+        return -1;
+    }
+    max_packets_ = max_packets;
+    max_bytes_ = max_bytes;
+    return 0;
+}
+
+void PacketQueue::uninit() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < packets_.size(); i++) { av_packet_free(&packets_[i]); }
+    packets_.clear();
+    bytes_ = 0;
+    finished_ = aborted_ = false;
+}
+
+int32_t PacketQueue::push(AVPacket *packet) {
+    AVPacket *queued = av_packet_alloc();
+    if (!queued) { return AVERROR(ENOMEM); }
+    av_packet_move_ref(queued, packet);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] {
+        return aborted_ || packets_.empty() || ((int32_t)packets_.size() < max_packets_ && bytes_ < max_bytes_);
+    });
+    if (aborted_) {
+        av_packet_free(&queued);
+        return AVERROR_EXIT;
+    }
+    packets_.push_back(queued);
+    bytes_ += queued->size;
+    cond_.notify_all();
+    return 0;
+}
+
+int32_t PacketQueue::pop(AVPacket *packet) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] { return aborted_ || finished_ || !packets_.empty(); });
+    if (aborted_) { return AVERROR_EXIT; }
+    if (packets_.empty()) { return AVERROR_EOF; }
+
+    AVPacket *queued = packets_.front();
+    packets_.pop_front();
+    bytes_ -= queued->size;
+    cond_.notify_all();
+    lock.unlock();
+
+    av_packet_move_ref(packet, queued);
+    av_packet_free(&queued);
+    return 0;
+}
+
+void PacketQueue::finish() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    cond_.notify_all();
+}
+
+void PacketQueue::abort() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_ = true;
+    cond_.notify_all();
+}
@@ -0,0 +1,232 @@
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+extern "C" {
+#include <libavutil/opt.h>
+#include <libswscale/swscale.h>
+}
+
+#include "sws_context_cache.h"
+
+namespace {
+
+struct SwsCacheKey {
+    int32_t src_width, src_height, src_pix_fmt;
+    int32_t dst_width, dst_height, dst_pix_fmt;
+    int32_t flags, threads;
+    int32_t colorspace, src_range, dst_range;
+
+    bool operator==(const SwsCacheKey &other) const {
+        return src_width == other.src_width && src_height == other.src_height && src_pix_fmt == other.src_pix_fmt
+               && dst_width == other.dst_width && dst_height == other.dst_height && dst_pix_fmt == other.dst_pix_fmt
+               && flags == other.flags && threads == other.threads && colorspace == other.colorspace
+               && src_range == other.src_range && dst_range == other.dst_range;
+    }
+};
+
+struct SwsCacheKeyHash {
+    size_t operator()(const SwsCacheKey &key) const {
+        const int32_t fields[] = {key.src_width,  key.src_height, key.src_pix_fmt, key.dst_width,
+                                  key.dst_height, key.dst_pix_fmt, key.flags,       key.threads,
+                                  key.colorspace, key.src_range,  key.dst_range};
+        size_t hash = 0;
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            hash = hash * 31 + std::hash<int32_t>()(fields[i]);
+        }
+        return hash;
+    }
+};
+
+struct SwsCacheEntry {
+    SwsCacheKey key;
+    struct SwsContext *ctx;
+};
+
+typedef std::list<SwsCacheEntry> SwsCacheList;
+
+} // namespace
+
+static std::mutex cache_mutex;
+static SwsCacheList idle_list; // 头部为最近使用
+static std::unordered_multimap<SwsCacheKey, SwsCacheList::iterator, SwsCacheKeyHash> idle_index;
+static std::unordered_map<struct SwsContext *, SwsCacheKey> busy_contexts;
+static size_t cache_capacity = 16;
+static SwsCacheStats cache_stats = {0, 0, 0, 0, 0, 0, 0};
+
+// 色彩参数总是按 key 重新设置：sws_getCachedContext 比较参数时不看色彩空间，
+// 复用的旧上下文可能还带着上一个 key 的系数
+static int32_t set_sws_colorspace(struct SwsContext *ctx, const SwsCacheKey &key) {
+    const int *coefficients = sws_getCoefficients(key.colorspace);
+    return sws_setColorspaceDetails(
+        ctx, coefficients, key.src_range, coefficients, key.dst_range, 0, 1 << 16, 1 << 16);
+}
+
+// 单线程的上下文交给 sws_getCachedContext，它会复用参数相同的旧上下文，否则释放后重建；
+// threads 选项无法通过 sws_getCachedContext 传入，多线程上下文只能按选项重新构建
+static struct SwsContext *build_sws_context(
+    const SwsCacheKey &key,
+    struct SwsContext *recycled,
+    int32_t recycled_threads) {
+    // sws_getCachedContext 比较参数时不看 threads，多线程的旧上下文会被原样返回，只有单线程的才能交给它复用
+    if (recycled && (key.threads != 1 || recycled_threads != 1)) {
+        sws_freeContext(recycled);
+        recycled = nullptr;
+    }
+
+    struct SwsContext *ctx = nullptr;
+    if (key.threads == 1) {
+        ctx = sws_getCachedContext(
+            recycled, key.src_width, key.src_height, (enum AVPixelFormat)key.src_pix_fmt, key.dst_width,
+            key.dst_height, (enum AVPixelFormat)key.dst_pix_fmt, key.flags, nullptr, nullptr, nullptr);
+        if (ctx && set_sws_colorspace(ctx, key) < 0) {
+            sws_freeContext(ctx);
+            return nullptr;
+        }
+        return ctx;
+    }
+
+    ctx = sws_alloc_context();
+    if (!ctx) { return nullptr; }
+
+    av_opt_set_int(ctx, "srcw", key.src_width, 0);
+    av_opt_set_int(ctx, "srch", key.src_height, 0);
+    av_opt_set_int(ctx, "src_format", key.src_pix_fmt, 0);
+    av_opt_set_int(ctx, "dstw", key.dst_width, 0);
+    av_opt_set_int(ctx, "dsth", key.dst_height, 0);
+    av_opt_set_int(ctx, "dst_format", key.dst_pix_fmt, 0);
+    av_opt_set_int(ctx, "sws_flags", key.flags, 0);
+    av_opt_set_int(ctx, "threads", key.threads, 0);
+
+    if (sws_init_context(ctx, nullptr, nullptr) < 0 || set_sws_colorspace(ctx, key) < 0) {
+        sws_freeContext(ctx);
+        return nullptr;
+    }
+    return ctx;
+}
+
+static void remove_idle_entry(SwsCacheList::iterator entry) {
+    auto range = idle_index.equal_range(entry->key);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == entry) {
+            idle_index.erase(it);
+            break;
+        }
+    }
+    idle_list.erase(entry);
+}
+
+struct SwsContext *acquire_sws_context(
+    int32_t src_width,
+    int32_t src_height,
+    enum AVPixelFormat src_pix_fmt,
+    int32_t dst_width,
+    int32_t dst_height,
+    enum AVPixelFormat dst_pix_fmt,
+    int32_t flags,
+    int32_t threads,
+    int32_t colorspace,
+    int32_t src_range,
+    int32_t dst_range) {
+    SwsCacheKey key = {src_width,   src_height, src_pix_fmt, dst_width, dst_height, dst_pix_fmt,
+                       flags,       threads,    colorspace,  src_range, dst_range};
+    struct SwsContext *recycled = nullptr;
+    int32_t recycled_threads = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto found = idle_index.find(key);
+        if (found != idle_index.end()) {
+            struct SwsContext *ctx = found->second->ctx;
+            idle_list.erase(found->second);
+            idle_index.erase(found);
+            busy_contexts[ctx] = key;
+            cache_stats.hits++;
+            return ctx;
+        }
+
+        cache_stats.misses++;
+        // 缓存已满时直接拿最久未用的上下文来重建，省去一次释放再分配
+        if (!idle_list.empty() && idle_list.size() >= cache_capacity) {
+            recycled = idle_list.back().ctx;
+            recycled_threads = idle_list.back().key.threads;
+            remove_idle_entry(std::prev(idle_list.end()));
+            cache_stats.evictions++;
+        }
+    }
+
+    // 构建高质量滤波器的上下文需要数毫秒，放在锁外进行
+    auto start = std::chrono::steady_clock::now();
+    struct SwsContext *ctx = build_sws_context(key, recycled, recycled_threads);
+    int64_t elapsed_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_stats.init_time_us += elapsed_us;
+    if (elapsed_us > cache_stats.max_init_time_us) { cache_stats.max_init_time_us = elapsed_us; }
+    if (!ctx) {
+        std::cerr << "Error: failed to build SwsContext." << std::endl;
+        return nullptr;
+    }
+    busy_contexts[ctx] = key;
+    return ctx;
+}
+
+void release_sws_context(struct SwsContext *ctx) {
+    if (!ctx) { return; }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto found = busy_contexts.find(ctx);
+    if (found == busy_contexts.end()) {
+        std::cerr << "Error: releasing a SwsContext not acquired from the cache." << std::endl;
+        return;
+    }
+
+    SwsCacheEntry entry = {found->second, ctx};
+    busy_contexts.erase(found);
+    idle_list.push_front(entry);
+    idle_index.insert(std::make_pair(entry.key, idle_list.begin()));
+
+    while (idle_list.size() > cache_capacity) {
+        sws_freeContext(idle_list.back().ctx);
+        remove_idle_entry(std::prev(idle_list.end()));
+        cache_stats.evictions++;
+    }
+}
+
+void set_sws_cache_capacity(int32_t capacity) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_capacity = capacity > 0 ? capacity : 1;
+    while (idle_list.size() > cache_capacity) {
+        sws_freeContext(idle_list.back().ctx);
+        remove_idle_entry(std::prev(idle_list.end()));
+        cache_stats.evictions++;
+    }
+}
+
+void get_sws_cache_stats(SwsCacheStats &stats) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    stats = cache_stats;
+    stats.idle = (int32_t)idle_list.size();
+    stats.in_use = (int32_t)busy_contexts.size();
+}
+
+void print_sws_cache_stats() {
+    SwsCacheStats stats;
+    get_sws_cache_stats(stats);
+    std::cout << "SwsContext cache hits:" << stats.hits << ", misses:" << stats.misses
+              << ", evictions:" << stats.evictions << ", init time:" << stats.init_time_us / 1000.0
+              << "ms (max " << stats.max_init_time_us / 1000.0 << "ms), idle:" << stats.idle
+              << ", in use:" << stats.in_use << std::endl;
+}
+
+void clear_sws_cache() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (auto it = idle_list.begin(); it != idle_list.end(); ++it) { sws_freeContext(it->ctx); }
+    idle_list.clear();
+    idle_index.clear();
+}
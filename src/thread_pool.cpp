@@ -0,0 +1,106 @@
+#include "thread_pool.h"
+
+static inline uint64_t pack_range(uint32_t begin, uint32_t end) {
+    return ((uint64_t)begin << 32) | end;
+}
+
+ThreadPool::ThreadPool(int32_t nb_threads)
+    : nb_threads_(nb_threads > 0 ? nb_threads : (int32_t)std::thread::hardware_concurrency())
+    , ranges_(nb_threads_ > 0 ? nb_threads_ : 1) {
+    if (nb_threads_ <= 0) { nb_threads_ = 1; }
+    for (int32_t i = 0; i < nb_threads_; i++) { ranges_[i].range.store(0); }
+    // 0 号线程是调用 execute 的线程
+    for (int32_t i = 1; i < nb_threads_; i++) { workers_.push_back(std::thread(&ThreadPool::worker_loop, this, i)); }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_cond_.notify_all();
+    for (size_t i = 0; i < workers_.size(); i++) { workers_[i].join(); }
+}
+
+bool ThreadPool::pop_job(int32_t thread_index, int32_t &job) {
+    std::atomic<uint64_t> &own = ranges_[thread_index].range;
+    uint64_t range = own.load();
+    while (true) {
+        uint32_t begin = (uint32_t)(range >> 32), end = (uint32_t)range;
+        if (begin >= end) { return false; }
+        if (own.compare_exchange_weak(range, pack_range(begin + 1, end))) {
+            job = (int32_t)begin;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal_job(int32_t thread_index, int32_t &job) {
+    for (int32_t i = 1; i < nb_threads_; i++) {
+        std::atomic<uint64_t> &victim = ranges_[(thread_index + i) % nb_threads_].range;
+        uint64_t range = victim.load();
+        while (true) {
+            uint32_t begin = (uint32_t)(range >> 32), end = (uint32_t)range;
+            if (begin >= end) { break; }
+            // 偷走后一半，victim 保留前一半继续顺序执行
+            uint32_t mid = begin + (end - begin) / 2;
+            if (victim.compare_exchange_weak(range, pack_range(begin, mid))) {
+                ranges_[thread_index].range.store(pack_range(mid + 1, end));
+                job = (int32_t)mid;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run_jobs(int32_t thread_index) {
+    int32_t job = 0;
+    while (pop_job(thread_index, job) || steal_job(thread_index, job)) { (*func_)(job, thread_index); }
+}
+
+void ThreadPool::worker_loop(int32_t thread_index) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cond_.wait(lock, [&] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) { return; }
+            seen_generation = generation_;
+        }
+
+        run_jobs(thread_index);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (++finished_workers_ == (int32_t)workers_.size()) { done_cond_.notify_one(); }
+    }
+}
+
+void ThreadPool::execute(int32_t nb_jobs, const JobFunc &func) {
+    if (nb_jobs <= 0) { return; }
+    if (nb_threads_ == 1 || nb_jobs == 1) {
+        for (int32_t job = 0; job < nb_jobs; job++) { func(job, 0); }
+        return;
+    }
+
+    for (int32_t i = 0; i < nb_threads_; i++) {
+        uint32_t begin = (uint32_t)((int64_t)nb_jobs * i / nb_threads_);
+        uint32_t end = (uint32_t)((int64_t)nb_jobs * (i + 1) / nb_threads_);
+        ranges_[i].range.store(pack_range(begin, end));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        func_ = &func;
+        finished_workers_ = 0;
+        generation_++;
+    }
+    start_cond_.notify_all();
+
+    run_jobs(0);
+
+    // 所有工作线程都退出本批次后 func 才能失效
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cond_.wait(lock, [&] { return finished_workers_ == (int32_t)workers_.size(); });
+    func_ = nullptr;
+}
@@ -96,15 +96,15 @@ int32_t init_video_encoder(const char* codec_name) {
 
 
 // encode 1 frame 的图像
-static int32_t encode_frame(bool flushing) {
+static int32_t encode_frame(const AVFrame *input_frame, bool flushing) {
     int32_t result = 0;
     if (!flushing) {
-        std::cout << "Send frame to encoder with pts: " << frame->pts << std::endl;
+        std::cout << "Send frame to encoder with pts: " << input_frame->pts << std::endl;
     }
 
     // nullptr 表示输入结束，将缓冲区内容输出
     // 图像送入编码器
-    result = avcodec_send_frame(codec_context, flushing ? nullptr : frame);
+    result = avcodec_send_frame(codec_context, flushing ? nullptr : input_frame);
     if (result < 0) {
         std::cerr << "Error: avcodec_send_frame could not send frame to encoder." << std::endl;
         return result;
@@ -150,14 +150,14 @@ int32_t encoding(int32_t n_frame_to_encode) {
         }
 
         frame->pts = i;  // 当前显示时间戳； dts 解码时间戳
-        result = encode_frame(false);
+        result = encode_frame(frame, false);
         if (result < 0) {
             std::cerr << "Error: encode_frame could not encode frame." << std::endl;
             return result;
         }
     }
 
-    result = encode_frame(true);
+    result = encode_frame(nullptr, true);
     if (result < 0) {
         std::cerr << "Error: encode_frame could not flush frame." << std::endl;
         return result;
@@ -166,6 +166,16 @@ int32_t encoding(int32_t n_frame_to_encode) {
     return 0;
 }
 
+// 编码器对送入的帧增加引用而不是拷贝，调用者随后 av_frame_unref 即可；nullptr 表示冲刷编码器
+int32_t encode_video_frame(const AVFrame *input_frame) {
+    int32_t result = encode_frame(input_frame, input_frame == nullptr);
+    if (result < 0) {
+        std::cerr << "Error: encode_frame could not encode frame." << std::endl;
+        return result;
+    }
+    return 0;
+}
+
 
 void destroy_video_encoder() {
     avcodec_free_context(&codec_context);
@@ -1,7 +1,11 @@
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include <libavfilter/buffersink.h>
@@ -10,17 +14,101 @@ extern "C" {
 #include <libavutil/opt.h>
 }
 
+#include "filter_graph_cache.h"
+#include "frame_pool.h"
 #include "io_data.h"
+#include "thread_pool.h"
 #include "video_filter_core.h"
+#include "video_native_stage.h"
 
 #define STREAM_FRAME_RATE 25
+#define INPUT_POOL_DEPTH 4
 
-AVFilterContext *buffersink_ctx;
 AVFilterContext *buffersrc_ctx;
 AVFilterGraph *filter_graph;
 
 AVFrame *input_frame = nullptr, *output_frame = nullptr;
 
+// 输入帧池：读入的帧以所有权转移的方式交给 buffersrc，滤镜图释放后缓冲区自动回到池中，
+// 下一次读入不会覆盖滤镜图仍在引用的数据
+static FramePool input_pool;
+
+// 每个输出对应一个 buffersink，名字与滤镜描述中的输出标签一致
+struct FilterOutput {
+    std::string name;
+    VideoFilterOutputCallback callback;
+    AVFilterContext *sink_ctx;
+};
+
+static std::vector<FilterOutput> filter_outputs;
+
+// 启用缓存时，相同描述、尺寸、输出和线程配置的滤镜图在任务之间复用，省去解析与格式协商
+static bool graph_cache_enabled = false;
+static std::string graph_key;
+static FilterGraphInstance graph_instance;
+static bool graph_reusable = false;      // init 时的 reusable 参数
+static bool graph_commands_sent = false; // 运行中修改过参数的滤镜图不再复用
+static int64_t graph_setup_us = 0;
+
+// 原生处理阶段：input_stages 在送入滤镜图前执行，output_stages 按输出名在回调前执行
+static std::vector<VideoStage *> input_stages;
+static std::map<std::string, std::vector<VideoStage *>> output_stages;
+
+// 自定义线程池，通过滤镜图的 execute 回调执行支持切片多线程的滤镜
+static ThreadPool *filter_thread_pool = nullptr;
+
+struct FilterTiming {
+    int64_t calls;
+    int64_t jobs;
+    int64_t time_us;
+};
+
+// 只有支持切片多线程的滤镜会经过 execute 回调，按滤镜实例名统计；原生阶段以 "native_" 前缀统计
+static std::map<std::string, FilterTiming> filter_timings;
+static int64_t filtered_frames = 0, filter_time_us = 0;
+
+static int graph_execute(AVFilterContext *ctx, avfilter_action_func *func, void *arg, int *ret, int nb_jobs) {
+    auto start = std::chrono::steady_clock::now();
+    filter_thread_pool->execute(nb_jobs, [&](int32_t job, int32_t) {
+        int result = func(ctx, arg, job, nb_jobs);
+        if (ret) { ret[job] = result; }
+    });
+
+    FilterTiming &timing = filter_timings[ctx->name];
+    timing.calls++;
+    timing.jobs += nb_jobs;
+    timing.time_us +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+// exclusive 表示 frame 的缓冲区只有调用者在使用，原地修改的阶段可以直接写入
+static int32_t run_stages(std::vector<VideoStage *> &stages, AVFrame *frame, bool exclusive) {
+    for (size_t i = 0; i < stages.size(); i++) {
+        VideoStage *stage = stages[i];
+        auto start = std::chrono::steady_clock::now();
+        if (stage->in_place() && !exclusive) {
+            if (av_frame_make_writable(frame) < 0) { return -1; }
+            exclusive = true;
+        }
+
+        // 输出新缓冲区的阶段在释放旧引用之前取得新引用，两者地址必然不同
+        AVBufferRef *buf = frame->buf[0];
+        if (stage->process(frame) < 0) {
+            std::cerr << "Failed  native stage " << stage->name() << " failed." << std::endl;
+            return -1;
+        }
+        if (frame->buf[0] != buf) { exclusive = true; }
+
+        FilterTiming &timing = filter_timings[std::string("native_") + stage->name()];
+        timing.calls++;
+        timing.jobs++;
+        timing.time_us +=
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    return 0;
+}
+
 static int32_t init_frames(int32_t width, int32_t height, enum AVPixelFormat pix_fmt) {
     int result = 0;
 
@@ -35,9 +123,9 @@ static int32_t init_frames(int32_t width, int32_t height, enum AVPixelFormat pix
     input_frame->height = height;
     input_frame->format = pix_fmt;
 
-    result = av_frame_get_buffer(input_frame, 0);
+    result = input_pool.init(input_frame, INPUT_POOL_DEPTH);
     if (result < 0) {
-        std::cerr << "Failed allocating frame buffer" << std::endl;
+        std::cerr << "Failed allocating input frame pool" << std::endl;
         return -2;
     }
 
@@ -50,7 +138,14 @@ static int32_t init_frames(int32_t width, int32_t height, enum AVPixelFormat pix
     return 0;
 }
 
-int32_t init_video_filter(int32_t width, int32_t height, const char *filter_describe) {
+// 按 filter_outputs 的顺序创建 buffersink，解析并配置滤镜图；线程参数必须在添加任何滤镜之前设置
+static int32_t build_filter_graph(
+    FilterGraphInstance &instance,
+    int32_t width,
+    int32_t height,
+    const char *filter_describe,
+    int32_t nb_threads,
+    int32_t thread_type) {
     int32_t result = 0;
     char args[512] = {0};
 
@@ -58,64 +153,79 @@ int32_t init_video_filter(int32_t width, int32_t height, const char *filter_desc
     const AVFilter *buffersink = avfilter_get_by_name("buffersink");
 
     AVFilterInOut *outputs = avfilter_inout_alloc();
-    AVFilterInOut *inputs = avfilter_inout_alloc();
+    AVFilterInOut *inputs = nullptr;
 
-    AVRational time_base = (AVRational){1, STREAM_FRAME_RATE};
     enum AVPixelFormat pix_fmts[] = {AV_PIX_FMT_YUV420P, AV_PIX_FMT_NONE};
 
     do {
-        filter_graph = avfilter_graph_alloc();
-        if (!outputs || !inputs || !filter_graph) {
+        instance.graph = avfilter_graph_alloc();
+        if (!outputs || !instance.graph) {
             std::cerr << "Failed create filter graph failed." << std::endl;
             result = AVERROR(ENOMEM);
             break;
         }
 
+        instance.graph->thread_type = thread_type;
+        instance.graph->nb_threads = nb_threads;
+        if (filter_thread_pool && thread_type) {
+            instance.graph->nb_threads = filter_thread_pool->size();
+            instance.graph->execute = graph_execute;
+        }
+
         // 一种配置参数方式之一
         snprintf(
             args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d", width, height,
             AV_PIX_FMT_YUV420P, 1, STREAM_FRAME_RATE, 1, 1);
-        result = avfilter_graph_create_filter(&buffersrc_ctx, buffersrc, "in", args, NULL, filter_graph);
-        if (result < 0) { std::cerr << "Failed create source filter." << std::endl; }
-
-        result = avfilter_graph_create_filter(&buffersink_ctx, buffersink, "out", NULL, NULL, filter_graph);
+        result = avfilter_graph_create_filter(&instance.src_ctx, buffersrc, "in", args, NULL, instance.graph);
         if (result < 0) {
-            std::cerr << "Failed  could not create sink filter." << std::endl;
+            std::cerr << "Failed create source filter." << std::endl;
             break;
         }
 
-        result = av_opt_set_int_list(buffersink_ctx, "pix_fmts", pix_fmts, AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
-        if (result < 0) {
-            std::cerr << "Failed  could not set output pixel format." << std::endl;
-            break;
+        instance.sink_ctxs.resize(filter_outputs.size());
+        // 逆序创建，头插后链表顺序与注册顺序一致
+        for (size_t i = filter_outputs.size(); i-- > 0;) {
+            const char *name = filter_outputs[i].name.c_str();
+            result = avfilter_graph_create_filter(&instance.sink_ctxs[i], buffersink, name, NULL, NULL, instance.graph);
+            if (result < 0) {
+                std::cerr << "Failed  could not create sink filter " << filter_outputs[i].name << std::endl;
+                break;
+            }
+
+            result = av_opt_set_int_list(
+                instance.sink_ctxs[i], "pix_fmts", pix_fmts, AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
+            if (result < 0) {
+                std::cerr << "Failed  could not set output pixel format." << std::endl;
+                break;
+            }
+
+            AVFilterInOut *input = avfilter_inout_alloc();
+            if (!input) {
+                result = AVERROR(ENOMEM);
+                break;
+            }
+            input->name = av_strdup(name);
+            input->filter_ctx = instance.sink_ctxs[i];
+            input->pad_idx = 0;
+            input->next = inputs;
+            inputs = input;
         }
+        if (result < 0) { break; }
 
         outputs->name = av_strdup("in");
-        outputs->filter_ctx = buffersrc_ctx;
+        outputs->filter_ctx = instance.src_ctx;
         outputs->pad_idx = 0;
         outputs->next = NULL;
 
-        inputs->name = av_strdup("out");
-        inputs->filter_ctx = buffersink_ctx;
-        inputs->pad_idx = 0;
-        inputs->next = NULL;
-
-        if ((result = avfilter_graph_parse_ptr(filter_graph, filter_describe, &inputs, &outputs, NULL)) < 0) {
+        if ((result = avfilter_graph_parse_ptr(instance.graph, filter_describe, &inputs, &outputs, NULL)) < 0) {
             std::cerr << "Failed  avfilter_graph_parse_ptr failed" << std::endl;
             break;
         }
 
-        if ((result = avfilter_graph_config(filter_graph, NULL)) < 0) {
+        if ((result = avfilter_graph_config(instance.graph, NULL)) < 0) {
             std::cerr << "Failed  Graph config invalid." << std::endl;
             break;
         }
-
-        result = init_frames(width, height, AV_PIX_FMT_YUV420P);
-        if (result < 0) {
-            std::cerr << "Failed  init frames failed." << std::endl;
-            break;
-        }
-
     } while (0);
 
     avfilter_inout_free(&inputs);
@@ -124,40 +234,157 @@ int32_t init_video_filter(int32_t width, int32_t height, const char *filter_desc
     return result;
 }
 
+int32_t init_video_filter(
+    int32_t width,
+    int32_t height,
+    const char *filter_describe,
+    int32_t nb_threads,
+    const char *thread_type,
+    bool use_thread_pool,
+    bool reusable) {
+    int32_t result = 0;
+    auto start = std::chrono::steady_clock::now();
+    graph_reusable = reusable;
+
+    int32_t graph_thread_type = 0;
+    if (!strcasecmp(thread_type, "slice")) {
+        graph_thread_type = AVFILTER_THREAD_SLICE;
+    } else if (strcasecmp(thread_type, "none")) {
+        std::cerr << "Failed unsupported thread type: " << std::string(thread_type) << std::endl;
+        return AVERROR(EINVAL);
+    }
+
+    if (use_thread_pool && graph_thread_type) { filter_thread_pool = new ThreadPool(nb_threads); }
+
+    // 没有注册输出时保持原来的单输出行为：标签 "out"，写入输出文件
+    if (filter_outputs.empty()) { filter_outputs.push_back({"out", write_frame_to_yuv, nullptr}); }
+
+    // 滤镜图的输入尺寸是经过所有前置原生阶段之后的尺寸
+    int32_t graph_width = width, graph_height = height;
+    for (size_t i = 0; i < input_stages.size(); i++) { input_stages[i]->output_size(graph_width, graph_height); }
+
+    auto builder = [&](FilterGraphInstance &instance) {
+        return build_filter_graph(instance, graph_width, graph_height, filter_describe, nb_threads, graph_thread_type);
+    };
+
+    if (graph_cache_enabled) {
+        graph_key = std::string(filter_describe) + "|" + std::to_string(graph_width) + "x"
+                    + std::to_string(graph_height) + "|" + std::to_string(AV_PIX_FMT_YUV420P) + "|"
+                    + std::to_string(nb_threads) + "|" + std::to_string(graph_thread_type) + "|"
+                    + std::to_string(filter_thread_pool != nullptr);
+        for (size_t i = 0; i < filter_outputs.size(); i++) { graph_key += "|" + filter_outputs[i].name; }
+        result = acquire_filter_graph(graph_key, builder, graph_instance);
+    } else {
+        result = builder(graph_instance);
+    }
+    if (result < 0) { return result; }
+
+    filter_graph = graph_instance.graph;
+    buffersrc_ctx = graph_instance.src_ctx;
+    for (size_t i = 0; i < filter_outputs.size(); i++) { filter_outputs[i].sink_ctx = graph_instance.sink_ctxs[i]; }
+
+    result = init_frames(width, height, AV_PIX_FMT_YUV420P);
+    if (result < 0) {
+        std::cerr << "Failed  init frames failed." << std::endl;
+        return result;
+    }
+
+    graph_setup_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return 0;
+}
+
+// 一次推入可能在每个分支上各产生若干帧，逐个输出取空
+static int32_t drain_filter_outputs() {
+    int32_t result = 0;
+    for (size_t i = 0; i < filter_outputs.size(); i++) {
+        FilterOutput &output = filter_outputs[i];
+        while (1) {
+            result = av_buffersink_get_frame(output.sink_ctx, output_frame);
+            if (result == AVERROR(EAGAIN) || result == AVERROR_EOF) {
+                break;
+            } else if (result < 0) {
+                std::cerr << "Failed  buffersink_get_frame failed." << std::endl;
+                return result;
+            }
+
+            // split 的各分支可能共享同一缓冲区，不能视为独占
+            result = run_stages(output_stages[output.name], output_frame, false);
+            if (result < 0) {
+                av_frame_unref(output_frame);
+                return result;
+            }
+
+            std::cout << "Frame filtered, output:" << output.name << ", width:" << output_frame->width
+                      << ", height : " << output_frame->height << std::endl;
+            result = output.callback(output_frame);
+            av_frame_unref(output_frame);
+            if (result < 0) {
+                std::cerr << "Failed  output " << output.name << " callback failed." << std::endl;
+                return result;
+            }
+        }
+    }
+    return 0;
+}
 
 static int32_t filter_frame() {
     int32_t result = 0;
-    if ((result = av_buffersrc_add_frame_flags(buffersrc_ctx, input_frame, AV_BUFFERSRC_FLAG_KEEP_REF)) < 0) {
+    auto start = std::chrono::steady_clock::now();
+    filtered_frames++;
+    // 不带 KEEP_REF：引用直接移交给 buffersrc，input_frame 被重置为空帧
+    if ((result = av_buffersrc_add_frame_flags(buffersrc_ctx, input_frame, 0)) < 0) {
         std::cerr << "Failed  add frame to buffer src failed." << std::endl;
         return result;
     }
 
-    while (1) {
-        result = av_buffersink_get_frame(buffersink_ctx, output_frame);
-        if (result == AVERROR(EAGAIN) || result == AVERROR_EOF) {
-            return 1;
-        } else if (result < 0) {
-            std::cerr << "Failed  buffersink_get_frame failed." << std::endl;
+    result = drain_filter_outputs();
+    if (result < 0) { return result; }
+
+    filter_time_us +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return 1;
+}
+
+static bool graph_returns_to_cache() {
+    return graph_cache_enabled && graph_reusable && !graph_commands_sent && is_filter_graph_reusable(filter_graph);
+}
+
+// 会归还到缓存的滤镜图只含无状态滤镜，取空输出即完成冲刷；buffersrc 收到 EOF 后不能再接收帧，
+// 这类滤镜图不发送 EOF。其余滤镜图发送 EOF，取出 fps、tmix 等滤镜缓存的剩余帧，之后不再复用
+static int32_t flush_filter_graph() {
+    if (!graph_returns_to_cache()) {
+        int32_t result = av_buffersrc_add_frame_flags(buffersrc_ctx, nullptr, 0);
+        if (result < 0) {
+            std::cerr << "Failed  send EOF to buffer src failed." << std::endl;
             return result;
         }
-
-        std::cout << "Frame filtered, width:" << output_frame->width << ", height : " << output_frame->height
-                  << std::endl;
-        write_frame_to_yuv(output_frame);
-        av_frame_unref(output_frame);
     }
-
-    return result;
+    return drain_filter_outputs();
 }
 
 int32_t filter_video(int32_t frame_cnt) {
     int32_t result = 0;
     for (size_t i = 0; i < frame_cnt; i++) {
+        result = input_pool.get_frame(input_frame);
+        if (result < 0) {
+            std::cerr << "Failed  get frame from input pool failed." << std::endl;
+            return result;
+        }
+
         result = read_yuv_to_frame(input_frame);
         if (result < 0) {
             std::cerr << "Failed  read_yuv_to_frame failed." << std::endl;
             return result;
         }
+        // 时间基为 1/STREAM_FRAME_RATE，按时间戳排队的命令依赖它；
+        // 带上时长，EOF 的时间戳才覆盖最后一帧，fps 等滤镜冲刷时不会少输出最后一帧
+        input_frame->pts = i;
+        input_frame->duration = 1;
+
+        // 池中的帧除池本身外只有这一个引用，原地修改是安全的
+        result = run_stages(input_stages, input_frame, true);
+        if (result < 0) { return result; }
 
         result = filter_frame();
         if (result < 0) {
@@ -165,15 +392,103 @@ int32_t filter_video(int32_t frame_cnt) {
             return result;
         }
     }
-    return result;
+    return flush_filter_graph();
 }
 
 static void free_frames() {
     av_frame_free(&input_frame);
+    input_pool.uninit();
     av_frame_free(&output_frame);
 }
 
+int32_t add_video_filter_output(const char *name, const VideoFilterOutputCallback &callback) {
+    if (filter_graph) {
+        std::cerr << "Failed  outputs must be added before init_video_filter." << std::endl;
+        return -1;
+    }
+    filter_outputs.push_back({name, callback, nullptr});
+    return 0;
+}
+
+int32_t add_video_filter_stage(VideoStage *stage, const char *output) {
+    if (!stage) { return -1; }
+    if (filter_graph && !output) {
+        delete stage;
+        std::cerr << "Failed  input stages must be added before init_video_filter." << std::endl;
+        return -1;
+    }
+    if (output) {
+        output_stages[output].push_back(stage);
+    } else {
+        input_stages.push_back(stage);
+    }
+    return 0;
+}
+
+// 立即修改滤镜参数，target 为滤镜实例名（如 "Parsed_crop_0"）、滤镜名或 "all"
+int32_t send_video_filter_command(const char *target, const char *cmd, const char *arg) {
+    char response[256] = {0};
+    graph_commands_sent = true;
+    int32_t result = avfilter_graph_send_command(filter_graph, target, cmd, arg, response, sizeof(response), 0);
+    if (result < 0) {
+        std::cerr << "Failed send command " << std::string(cmd) << " to " << std::string(target) << std::endl;
+        return result;
+    }
+    if (response[0]) { std::cout << "Filter response: " << response << std::endl; }
+    return 0;
+}
+
+// 在时间戳不小于 ts 秒的第一帧进入滤镜前修改参数，保证按帧精确生效
+int32_t queue_video_filter_command(const char *target, const char *cmd, const char *arg, double ts) {
+    graph_commands_sent = true;
+    int32_t result = avfilter_graph_queue_command(filter_graph, target, cmd, arg, 0, ts);
+    if (result < 0) {
+        std::cerr << "Failed queue command " << std::string(cmd) << " to " << std::string(target) << std::endl;
+        return result;
+    }
+    return 0;
+}
+
+void enable_video_filter_graph_cache(bool enable) {
+    graph_cache_enabled = enable;
+}
+
+void print_video_filter_stats() {
+    std::cout << "Graph setup time:" << graph_setup_us / 1000.0 << "ms" << std::endl;
+    if (filtered_frames == 0) { return; }
+    std::cout << "Filtered frames:" << filtered_frames << ", avg time per frame:"
+              << filter_time_us / 1000.0 / filtered_frames << "ms, input pool size:" << input_pool.size()
+              << std::endl;
+    for (auto it = filter_timings.begin(); it != filter_timings.end(); ++it) {
+        std::cout << "  filter " << it->first << ": calls:" << it->second.calls << ", jobs:" << it->second.jobs
+                  << ", time:" << it->second.time_us / 1000.0 << "ms" << std::endl;
+    }
+}
+
 void destroy_video_filter() {
     free_frames();
-    avfilter_graph_free(&filter_graph);
+    if (graph_cache_enabled) {
+        release_filter_graph(graph_key, graph_instance, graph_reusable && !graph_commands_sent);
+    } else {
+        avfilter_graph_free(&graph_instance.graph);
+    }
+    graph_instance.src_ctx = nullptr;
+    graph_instance.sink_ctxs.clear();
+    filter_graph = nullptr;
+    buffersrc_ctx = nullptr;
+    graph_reusable = false;
+    graph_commands_sent = false;
+    graph_setup_us = 0;
+    delete filter_thread_pool;
+    filter_thread_pool = nullptr;
+    filter_outputs.clear();
+    for (size_t i = 0; i < input_stages.size(); i++) { delete input_stages[i]; }
+    input_stages.clear();
+    for (auto it = output_stages.begin(); it != output_stages.end(); ++it) {
+        for (size_t i = 0; i < it->second.size(); i++) { delete it->second[i]; }
+    }
+    output_stages.clear();
+    filter_timings.clear();
+    filtered_frames = 0;
+    filter_time_us = 0;
 }
\ No newline at end of file
@@ -0,0 +1,401 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+extern "C" {
+#include <libavutil/common.h>
+#include <libavutil/cpu.h>
+#include <libavutil/mem.h>
+}
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2_KERNELS 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_KERNELS 1
+#endif
+
+#include "video_native_stage.h"
+
+#define STAGE_POOL_DEPTH 4
+
+// ---------------------------------------------------------------------------
+// 行内核：水平翻转与 alpha 混合
+
+static void flip_row_c(uint8_t *dst, const uint8_t *src, int32_t width, int32_t start) {
+    for (int32_t i = start; i < width; i++) { dst[i] = src[width - 1 - i]; }
+}
+
+// dst = (src * a + dst * (255 - a)) / 255，四舍五入；(t + (t >> 8)) >> 8 在 t <= 255 * 255 + 128 时与除法结果一致
+static void blend_row_c(uint8_t *dst, const uint8_t *src, const uint8_t *alpha, int32_t width, int32_t start) {
+    for (int32_t i = start; i < width; i++) {
+        uint32_t t = src[i] * alpha[i] + dst[i] * (255 - alpha[i]) + 128;
+        dst[i] = (uint8_t)((t + (t >> 8)) >> 8);
+    }
+}
+
+#if HAVE_SSE2_KERNELS
+static inline __m128i reverse_bytes_sse2(__m128i x) {
+    x = _mm_shuffle_epi32(x, _MM_SHUFFLE(0, 1, 2, 3));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+static void flip_row_sse2(uint8_t *dst, const uint8_t *src, int32_t width) {
+    int32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + width - 16 - i));
+        _mm_storeu_si128((__m128i *)(dst + i), reverse_bytes_sse2(x));
+    }
+    flip_row_c(dst, src, width, i);
+}
+
+static inline __m128i blend_epi16_sse2(__m128i s, __m128i d, __m128i a) {
+    const __m128i c255 = _mm_set1_epi16(255), c128 = _mm_set1_epi16(128);
+    // 各项之和不超过 65153，按无符号 16 位计算不会溢出
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(c255, a)));
+    t = _mm_add_epi16(t, c128);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static void blend_row_sse2(uint8_t *dst, const uint8_t *src, const uint8_t *alpha, int32_t width) {
+    const __m128i zero = _mm_setzero_si128();
+    int32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i a = _mm_loadu_si128((const __m128i *)(alpha + i));
+        __m128i lo = blend_epi16_sse2(
+            _mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(a, zero));
+        __m128i hi = blend_epi16_sse2(
+            _mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blend_row_c(dst, src, alpha, width, i);
+}
+#endif
+
+#if HAVE_NEON_KERNELS
+static void flip_row_neon(uint8_t *dst, const uint8_t *src, int32_t width) {
+    int32_t i = 0;
+    for (; i + 16 <= width; i += 16) {
+        uint8x16_t x = vrev64q_u8(vld1q_u8(src + width - 16 - i));
+        vst1q_u8(dst + i, vcombine_u8(vget_high_u8(x), vget_low_u8(x)));
+    }
+    flip_row_c(dst, src, width, i);
+}
+
+static void blend_row_neon(uint8_t *dst, const uint8_t *src, const uint8_t *alpha, int32_t width) {
+    const uint8x8_t c255 = vdup_n_u8(255);
+    const uint16x8_t c128 = vdupq_n_u16(128);
+    int32_t i = 0;
+    for (; i + 8 <= width; i += 8) {
+        uint8x8_t s = vld1_u8(src + i), d = vld1_u8(dst + i), a = vld1_u8(alpha + i);
+        uint16x8_t t = vaddq_u16(vmlal_u8(vmull_u8(s, a), d, vsub_u8(c255, a)), c128);
+        vst1_u8(dst + i, vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8));
+    }
+    blend_row_c(dst, src, alpha, width, i);
+}
+#endif
+
+static void flip_row(uint8_t *dst, const uint8_t *src, int32_t width) {
+#if HAVE_SSE2_KERNELS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_SSE2) {
+        flip_row_sse2(dst, src, width);
+        return;
+    }
+#endif
+#if HAVE_NEON_KERNELS
+    flip_row_neon(dst, src, width);
+    return;
+#endif
+    flip_row_c(dst, src, width, 0);
+}
+
+static void blend_row(uint8_t *dst, const uint8_t *src, const uint8_t *alpha, int32_t width) {
+#if HAVE_SSE2_KERNELS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_SSE2) {
+        blend_row_sse2(dst, src, alpha, width);
+        return;
+    }
+#endif
+#if HAVE_NEON_KERNELS
+    blend_row_neon(dst, src, alpha, width);
+    return;
+#endif
+    blend_row_c(dst, src, alpha, width, 0);
+}
+
+// ---------------------------------------------------------------------------
+
+static int32_t check_yuv420p(const AVFrame *frame, const char *stage_name) {
+    if (frame->format != AV_PIX_FMT_YUV420P) {
+        std::cerr << "Error: " << stage_name << " stage only supports YUV420P input." << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// 从池中取一个 width x height 的新帧，尺寸变化时重建池
+static int32_t get_pooled_frame(
+    FramePool &pool,
+    int32_t &pool_width,
+    int32_t &pool_height,
+    int32_t width,
+    int32_t height,
+    AVFrame *dst) {
+    if (pool_width != width || pool_height != height) {
+        pool.uninit();
+        dst->width = width;
+        dst->height = height;
+        dst->format = AV_PIX_FMT_YUV420P;
+        if (pool.init(dst, STAGE_POOL_DEPTH) < 0) { return -1; }
+        pool_width = width;
+        pool_height = height;
+    }
+    return pool.get_frame(dst);
+}
+
+// 用新帧替换 frame 的内容，保留时间戳等属性
+static int32_t replace_frame(AVFrame *frame, AVFrame *out) {
+    int32_t result = av_frame_copy_props(out, frame);
+    if (result < 0) { return result; }
+    av_frame_unref(frame);
+    av_frame_move_ref(frame, out);
+    return 0;
+}
+
+CropStage::CropStage(int32_t x, int32_t y, int32_t width, int32_t height)
+    : x_(x), y_(y), width_(width), height_(height) {}
+
+void CropStage::output_size(int32_t &width, int32_t &height) const {
+    width = width_;
+    height = height_;
+}
+
+int32_t CropStage::process(AVFrame *frame) {
+    if (check_yuv420p(frame, name()) < 0) { return -1; }
+    if ((x_ | y_) & 1 || x_ < 0 || y_ < 0 || width_ <= 0 || height_ <= 0 || x_ + width_ > frame->width
+        || y_ + height_ > frame->height) {
+        std::cerr << "Error: invalid crop " << width_ << "x" << height_ << "+" << x_ << "+" << y_ << " for "
+                  << frame->width << "x" << frame->height << " frame." << std::endl;
+        return -1;
+    }
+
+    frame->crop_left = x_;
+    frame->crop_top = y_;
+    frame->crop_right = frame->width - x_ - width_;
+    frame->crop_bottom = frame->height - y_ - height_;
+    // 不要求裁剪后的指针对齐，否则左边界会被向下对齐
+    return av_frame_apply_cropping(frame, AV_FRAME_CROP_UNALIGNED);
+}
+
+PadStage::PadStage(
+    int32_t x,
+    int32_t y,
+    int32_t width,
+    int32_t height,
+    uint8_t y_color,
+    uint8_t u_color,
+    uint8_t v_color)
+    : x_(x), y_(y), width_(width), height_(height) {
+    color_[0] = y_color;
+    color_[1] = u_color;
+    color_[2] = v_color;
+}
+
+void PadStage::output_size(int32_t &width, int32_t &height) const {
+    width = width_;
+    height = height_;
+}
+
+int32_t PadStage::process(AVFrame *frame) {
+    if (check_yuv420p(frame, name()) < 0) { return -1; }
+    if ((x_ | y_) & 1 || x_ < 0 || y_ < 0 || x_ + frame->width > width_ || y_ + frame->height > height_) {
+        std::cerr << "Error: invalid pad " << width_ << "x" << height_ << "+" << x_ << "+" << y_ << " for "
+                  << frame->width << "x" << frame->height << " frame." << std::endl;
+        return -1;
+    }
+
+    AVFrame *out = av_frame_alloc();
+    if (!out || get_pooled_frame(pool_, pool_width_, pool_height_, width_, height_, out) < 0) {
+        std::cerr << "Error: could not get pad output frame." << std::endl;
+        av_frame_free(&out);
+        return -1;
+    }
+
+    for (int32_t plane = 0; plane < 3; plane++) {
+        int32_t shift = plane ? 1 : 0;
+        int32_t out_w = (width_ + shift) >> shift, out_h = (height_ + shift) >> shift;
+        int32_t in_w = (frame->width + shift) >> shift, in_h = (frame->height + shift) >> shift;
+        int32_t left = x_ >> shift, top = y_ >> shift;
+        for (int32_t row = 0; row < out_h; row++) {
+            uint8_t *dst = out->data[plane] + row * out->linesize[plane];
+            if (row < top || row >= top + in_h) {
+                memset(dst, color_[plane], out_w);
+                continue;
+            }
+            memset(dst, color_[plane], left);
+            memcpy(dst + left, frame->data[plane] + (row - top) * frame->linesize[plane], in_w);
+            memset(dst + left + in_w, color_[plane], out_w - left - in_w);
+        }
+    }
+
+    int32_t result = replace_frame(frame, out);
+    av_frame_free(&out);
+    return result;
+}
+
+int32_t HFlipStage::process(AVFrame *frame) {
+    if (check_yuv420p(frame, name()) < 0) { return -1; }
+
+    AVFrame *out = av_frame_alloc();
+    if (!out || get_pooled_frame(pool_, pool_width_, pool_height_, frame->width, frame->height, out) < 0) {
+        std::cerr << "Error: could not get hflip output frame." << std::endl;
+        av_frame_free(&out);
+        return -1;
+    }
+
+    for (int32_t plane = 0; plane < 3; plane++) {
+        int32_t shift = plane ? 1 : 0;
+        int32_t width = (frame->width + shift) >> shift, height = (frame->height + shift) >> shift;
+        for (int32_t row = 0; row < height; row++) {
+            flip_row(
+                out->data[plane] + row * out->linesize[plane], frame->data[plane] + row * frame->linesize[plane],
+                width);
+        }
+    }
+
+    int32_t result = replace_frame(frame, out);
+    av_frame_free(&out);
+    return result;
+}
+
+OverlayStage::OverlayStage(int32_t x, int32_t y) : x_(x), y_(y) {}
+
+OverlayStage::~OverlayStage() {
+    av_frame_free(&image_);
+    av_freep(&chroma_alpha_);
+}
+
+int32_t OverlayStage::set_image(const AVFrame *image) {
+    if (image->format != AV_PIX_FMT_YUVA420P) {
+        std::cerr << "Error: overlay image must be YUVA420P." << std::endl;
+        return -1;
+    }
+
+    av_frame_free(&image_);
+    av_freep(&chroma_alpha_);
+    image_ = av_frame_clone(image);
+    int32_t chroma_w = (image->width + 1) >> 1, chroma_h = (image->height + 1) >> 1;
+    chroma_alpha_ = (uint8_t *)av_malloc(chroma_w * chroma_h);
+    if (!image_ || !chroma_alpha_) {
+        std::cerr << "Error: could not allocate overlay image." << std::endl;
+        return -1;
+    }
+
+    const uint8_t *alpha = image->data[3];
+    int32_t stride = image->linesize[3];
+    for (int32_t row = 0; row < chroma_h; row++) {
+        int32_t y0 = row * 2, y1 = FFMIN(y0 + 1, image->height - 1);
+        for (int32_t col = 0; col < chroma_w; col++) {
+            int32_t x0 = col * 2, x1 = FFMIN(x0 + 1, image->width - 1);
+            int32_t sum = alpha[y0 * stride + x0] + alpha[y0 * stride + x1] + alpha[y1 * stride + x0]
+                          + alpha[y1 * stride + x1];
+            chroma_alpha_[row * chroma_w + col] = (uint8_t)((sum + 2) >> 2);
+        }
+    }
+    return 0;
+}
+
+int32_t OverlayStage::process(AVFrame *frame) {
+    if (check_yuv420p(frame, name()) < 0) { return -1; }
+    if (!image_) {
+        std::cerr << "Error: overlay image is not set." << std::endl;
+        return -1;
+    }
+    if ((x_ | y_) & 1 || x_ < 0 || y_ < 0) {
+        std::cerr << "Error: overlay position must be even and non-negative." << std::endl;
+        return -1;
+    }
+
+    int32_t chroma_w = (image_->width + 1) >> 1;
+    for (int32_t plane = 0; plane < 3; plane++) {
+        int32_t shift = plane ? 1 : 0;
+        int32_t left = x_ >> shift, top = y_ >> shift;
+        int32_t frame_w = (frame->width + shift) >> shift, frame_h = (frame->height + shift) >> shift;
+        int32_t width = FFMIN((image_->width + shift) >> shift, frame_w - left);
+        int32_t height = FFMIN((image_->height + shift) >> shift, frame_h - top);
+        for (int32_t row = 0; row < height; row++) {
+            const uint8_t *alpha =
+                plane ? chroma_alpha_ + row * chroma_w : image_->data[3] + row * image_->linesize[3];
+            blend_row(
+                frame->data[plane] + (top + row) * frame->linesize[plane] + left,
+                image_->data[plane] + row * image_->linesize[plane], alpha, width);
+        }
+    }
+    return 0;
+}
+
+static AVFrame *read_yuva420p_image(const char *file_name, int32_t width, int32_t height) {
+    FILE *file = fopen(file_name, "rb");
+    AVFrame *image = av_frame_alloc();
+    int32_t result = (file && image) ? 0 : -1;
+
+    if (result == 0) {
+        image->width = width;
+        image->height = height;
+        image->format = AV_PIX_FMT_YUVA420P;
+        result = av_frame_get_buffer(image, 0);
+    }
+    for (int32_t plane = 0; result == 0 && plane < 4; plane++) {
+        int32_t shift = (plane == 1 || plane == 2) ? 1 : 0;
+        int32_t plane_w = (width + shift) >> shift, plane_h = (height + shift) >> shift;
+        for (int32_t row = 0; row < plane_h; row++) {
+            if (fread(image->data[plane] + row * image->linesize[plane], 1, plane_w, file) != (size_t)plane_w) {
+                result = -1;
+                break;
+            }
+        }
+    }
+
+    if (file) { fclose(file); }
+    if (result < 0) {
+        std::cerr << "Error: could not read YUVA420P image " << std::string(file_name) << std::endl;
+        av_frame_free(&image);
+    }
+    return image;
+}
+
+VideoStage *create_video_stage(const char *describe) {
+    int32_t x = 0, y = 0, width = 0, height = 0;
+    char file_name[1024] = {0};
+
+    if (!strcmp(describe, "hflip")) { return new HFlipStage(); }
+    if (sscanf(describe, "crop=%d:%d:%d:%d", &width, &height, &x, &y) == 4) {
+        return new CropStage(x, y, width, height);
+    }
+    if (sscanf(describe, "pad=%d:%d:%d:%d", &width, &height, &x, &y) == 4) {
+        return new PadStage(x, y, width, height);
+    }
+    if (sscanf(describe, "overlay=%1023[^:]:%d:%d:%d:%d", file_name, &width, &height, &x, &y) == 5) {
+        AVFrame *image = read_yuva420p_image(file_name, width, height);
+        if (!image) { return nullptr; }
+        OverlayStage *stage = new OverlayStage(x, y);
+        int32_t result = stage->set_image(image);
+        av_frame_free(&image);
+        if (result < 0) {
+            delete stage;
+            return nullptr;
+        }
+        return stage;
+    }
+
+    std::cerr << "Error: unknown native stage: " << std::string(describe) << std::endl;
+    return nullptr;
+}
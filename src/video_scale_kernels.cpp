@@ -0,0 +1,367 @@
+#include <cstring>
+
+extern "C" {
+#include <libavutil/cpu.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define HAVE_SSE2_KERNELS 1
+#if defined(__GNUC__)
+#define HAVE_AVX2_KERNELS 1
+#define TARGET_AVX2       __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAVE_NEON_KERNELS 1
+#endif
+
+#include "video_scale_kernels.h"
+
+// ---------------------------------------------------------------------------
+// 行内核：U/V 交织与解交织
+
+static void interleave_row_c(const uint8_t *u, const uint8_t *v, uint8_t *uv, int32_t width, int32_t start) {
+    for (int32_t i = start; i < width; i++) {
+        uv[2 * i] = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+}
+
+static void deinterleave_row_c(const uint8_t *uv, uint8_t *u, uint8_t *v, int32_t width, int32_t start) {
+    for (int32_t i = start; i < width; i++) {
+        u[i] = uv[2 * i];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+#if HAVE_AVX2_KERNELS
+TARGET_AVX2 static void interleave_row_avx2(const uint8_t *u, const uint8_t *v, uint8_t *uv, int32_t width) {
+    int32_t i = 0;
+    for (; i + 32 <= width; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(u + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(v + i));
+        // unpack 按 128 位通道进行，再用 permute 把两个通道的结果按顺序拼回
+        __m256i lo = _mm256_unpacklo_epi8(a, b);
+        __m256i hi = _mm256_unpackhi_epi8(a, b);
+        _mm256_storeu_si256((__m256i *)(uv + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(uv + 2 * i + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave_row_c(u, v, uv, width, i);
+}
+
+TARGET_AVX2 static void deinterleave_row_avx2(const uint8_t *uv, uint8_t *u, uint8_t *v, int32_t width) {
+    const __m256i mask = _mm256_set1_epi16(0x00ff);
+    int32_t i = 0;
+    for (; i + 32 <= width; i += 32) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i *)(uv + 2 * i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i *)(uv + 2 * i + 32));
+        __m256i even = _mm256_packus_epi16(_mm256_and_si256(x0, mask), _mm256_and_si256(x1, mask));
+        __m256i odd = _mm256_packus_epi16(_mm256_srli_epi16(x0, 8), _mm256_srli_epi16(x1, 8));
+        _mm256_storeu_si256((__m256i *)(u + i), _mm256_permute4x64_epi64(even, 0xd8));
+        _mm256_storeu_si256((__m256i *)(v + i), _mm256_permute4x64_epi64(odd, 0xd8));
+    }
+    deinterleave_row_c(uv, u, v, width, i);
+}
+#endif
+
+static void interleave_row(const uint8_t *u, const uint8_t *v, uint8_t *uv, int32_t width) {
+    int32_t i = 0;
+#if HAVE_AVX2_KERNELS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+        interleave_row_avx2(u, v, uv, width);
+        return;
+    }
+#endif
+#if HAVE_SSE2_KERNELS
+    for (; i + 16 <= width; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(u + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(v + i));
+        _mm_storeu_si128((__m128i *)(uv + 2 * i), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128((__m128i *)(uv + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+    }
+#elif HAVE_NEON_KERNELS
+    for (; i + 16 <= width; i += 16) {
+        uint8x16x2_t pair;
+        pair.val[0] = vld1q_u8(u + i);
+        pair.val[1] = vld1q_u8(v + i);
+        vst2q_u8(uv + 2 * i, pair);
+    }
+#endif
+    interleave_row_c(u, v, uv, width, i);
+}
+
+static void deinterleave_row(const uint8_t *uv, uint8_t *u, uint8_t *v, int32_t width) {
+    int32_t i = 0;
+#if HAVE_AVX2_KERNELS
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) {
+        deinterleave_row_avx2(uv, u, v, width);
+        return;
+    }
+#endif
+#if HAVE_SSE2_KERNELS
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    for (; i + 16 <= width; i += 16) {
+        __m128i x0 = _mm_loadu_si128((const __m128i *)(uv + 2 * i));
+        __m128i x1 = _mm_loadu_si128((const __m128i *)(uv + 2 * i + 16));
+        _mm_storeu_si128((__m128i *)(u + i), _mm_packus_epi16(_mm_and_si128(x0, mask), _mm_and_si128(x1, mask)));
+        _mm_storeu_si128((__m128i *)(v + i), _mm_packus_epi16(_mm_srli_epi16(x0, 8), _mm_srli_epi16(x1, 8)));
+    }
+#elif HAVE_NEON_KERNELS
+    for (; i + 16 <= width; i += 16) {
+        uint8x16x2_t pair = vld2q_u8(uv + 2 * i);
+        vst1q_u8(u + i, pair.val[0]);
+        vst1q_u8(v + i, pair.val[1]);
+    }
+#endif
+    deinterleave_row_c(uv, u, v, width, i);
+}
+
+// ---------------------------------------------------------------------------
+// 行内核：盒式下采样，输出像素为对应 NxN 输入块的四舍五入均值
+
+static void box2x_row(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, int32_t dst_width) {
+    int32_t i = 0;
+#if HAVE_SSE2_KERNELS
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi32(2);
+    for (; i + 8 <= dst_width; i += 8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(r0 + 2 * i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(r1 + 2 * i));
+        // 先纵向相加，再用 madd 把相邻两列相加成 32 位
+        __m128i sum_lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i sum_hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        __m128i quad_lo = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(sum_lo, ones), round), 2);
+        __m128i quad_hi = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(sum_hi, ones), round), 2);
+        __m128i packed = _mm_packs_epi32(quad_lo, quad_hi);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(packed, packed));
+    }
+#elif HAVE_NEON_KERNELS
+    for (; i + 8 <= dst_width; i += 8) {
+        uint16x8_t sum = vaddq_u16(vpaddlq_u8(vld1q_u8(r0 + 2 * i)), vpaddlq_u8(vld1q_u8(r1 + 2 * i)));
+        vst1_u8(dst + i, vrshrn_n_u16(sum, 2));
+    }
+#endif
+    for (; i < dst_width; i++) { dst[i] = (r0[2 * i] + r0[2 * i + 1] + r1[2 * i] + r1[2 * i + 1] + 2) >> 2; }
+}
+
+static void box4x_row(const uint8_t *src, int32_t src_linesize, uint8_t *dst, int32_t dst_width) {
+    int32_t i = 0;
+#if HAVE_SSE2_KERNELS
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i round = _mm_set1_epi32(8);
+    for (; i + 8 <= dst_width; i += 8) {
+        // 4 行纵向相加成 16 位（最大 1020），每次处理 32 列输入、8 个输出
+        __m128i cols[4] = {zero, zero, zero, zero};
+        for (int32_t j = 0; j < 4; j++) {
+            const uint8_t *row = src + j * src_linesize + 4 * i;
+            __m128i a = _mm_loadu_si128((const __m128i *)row);
+            __m128i b = _mm_loadu_si128((const __m128i *)(row + 16));
+            cols[0] = _mm_add_epi16(cols[0], _mm_unpacklo_epi8(a, zero));
+            cols[1] = _mm_add_epi16(cols[1], _mm_unpackhi_epi8(a, zero));
+            cols[2] = _mm_add_epi16(cols[2], _mm_unpacklo_epi8(b, zero));
+            cols[3] = _mm_add_epi16(cols[3], _mm_unpackhi_epi8(b, zero));
+        }
+        // 两次 madd 把相邻 4 列相加：第一次得到列对之和，收窄回 16 位后再求一次
+        __m128i pairs_a = _mm_packs_epi32(_mm_madd_epi16(cols[0], ones), _mm_madd_epi16(cols[1], ones));
+        __m128i pairs_b = _mm_packs_epi32(_mm_madd_epi16(cols[2], ones), _mm_madd_epi16(cols[3], ones));
+        __m128i quad_a = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(pairs_a, ones), round), 4);
+        __m128i quad_b = _mm_srli_epi32(_mm_add_epi32(_mm_madd_epi16(pairs_b, ones), round), 4);
+        __m128i packed = _mm_packs_epi32(quad_a, quad_b);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(packed, packed));
+    }
+#elif HAVE_NEON_KERNELS
+    for (; i + 8 <= dst_width; i += 8) {
+        uint16x8_t pairs_a = vdupq_n_u16(0), pairs_b = vdupq_n_u16(0);
+        for (int32_t j = 0; j < 4; j++) {
+            const uint8_t *row = src + j * src_linesize + 4 * i;
+            pairs_a = vpadalq_u8(pairs_a, vld1q_u8(row));
+            pairs_b = vpadalq_u8(pairs_b, vld1q_u8(row + 16));
+        }
+        uint16x4_t quad_a = vpadd_u16(vget_low_u16(pairs_a), vget_high_u16(pairs_a));
+        uint16x4_t quad_b = vpadd_u16(vget_low_u16(pairs_b), vget_high_u16(pairs_b));
+        vst1_u8(dst + i, vrshrn_n_u16(vcombine_u16(quad_a, quad_b), 4));
+    }
+#endif
+    for (; i < dst_width; i++) {
+        uint32_t sum = 8;
+        for (int32_t j = 0; j < 4; j++) {
+            const uint8_t *row = src + j * src_linesize + 4 * i;
+            sum += row[0] + row[1] + row[2] + row[3];
+        }
+        dst[i] = (uint8_t)(sum >> 4);
+    }
+}
+
+static void downscale_plane(
+    const uint8_t *src,
+    int32_t src_linesize,
+    uint8_t *dst,
+    int32_t dst_linesize,
+    int32_t dst_width,
+    int32_t dst_height,
+    int32_t factor) {
+    for (int32_t y = 0; y < dst_height; y++) {
+        const uint8_t *row = src + y * factor * src_linesize;
+        if (factor == 2) {
+            box2x_row(row, row + src_linesize, dst + y * dst_linesize, dst_width);
+        } else {
+            box4x_row(row, src_linesize, dst + y * dst_linesize, dst_width);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 帧内核
+
+static int32_t yuv420p_to_nv12(const AVFrame *src, AVFrame *dst) {
+    av_image_copy_plane(dst->data[0], dst->linesize[0], src->data[0], src->linesize[0], src->width, src->height);
+    for (int32_t y = 0; y < src->height / 2; y++) {
+        interleave_row(
+            src->data[1] + y * src->linesize[1], src->data[2] + y * src->linesize[2],
+            dst->data[1] + y * dst->linesize[1], src->width / 2);
+    }
+    return 0;
+}
+
+static int32_t nv12_to_yuv420p(const AVFrame *src, AVFrame *dst) {
+    av_image_copy_plane(dst->data[0], dst->linesize[0], src->data[0], src->linesize[0], src->width, src->height);
+    for (int32_t y = 0; y < src->height / 2; y++) {
+        deinterleave_row(
+            src->data[1] + y * src->linesize[1], dst->data[1] + y * dst->linesize[1],
+            dst->data[2] + y * dst->linesize[2], src->width / 2);
+    }
+    return 0;
+}
+
+static int32_t yuv420p_downscale(const AVFrame *src, AVFrame *dst, int32_t factor) {
+    for (int32_t plane = 0; plane < 3; plane++) {
+        int32_t shift = plane ? 1 : 0;
+        downscale_plane(
+            src->data[plane], src->linesize[plane], dst->data[plane], dst->linesize[plane], dst->width >> shift,
+            dst->height >> shift, factor);
+    }
+    return 0;
+}
+
+static int32_t yuv420p_downscale_2x(const AVFrame *src, AVFrame *dst) {
+    return yuv420p_downscale(src, dst, 2);
+}
+
+static int32_t yuv420p_downscale_4x(const AVFrame *src, AVFrame *dst) {
+    return yuv420p_downscale(src, dst, 4);
+}
+
+// BT.709 有限范围，Q15 定点系数
+#define BT709_Y_R  5983
+#define BT709_Y_G  20127
+#define BT709_Y_B  2032
+#define BT709_CB_R (-3298)
+#define BT709_CB_G (-11094)
+#define BT709_CB_B 14392
+#define BT709_CR_R 14392
+#define BT709_CR_G (-13073)
+#define BT709_CR_B (-1319)
+
+#define BT709_Y_SCALE 38155
+#define BT709_R_CR    58745
+#define BT709_G_CB    6988
+#define BT709_G_CR    17462
+#define BT709_B_CB    69219
+
+static inline uint8_t clip_uint8(int32_t value) {
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// RGB24 的 3 字节交错布局在 SSE2 下没有廉价的解交织，两个 RGB 内核保持标量实现
+static int32_t rgb24_to_yuv420p(const AVFrame *src, AVFrame *dst) {
+    const int32_t round = 1 << 14;
+    for (int32_t y = 0; y < src->height; y += 2) {
+        const uint8_t *rgb0 = src->data[0] + y * src->linesize[0];
+        const uint8_t *rgb1 = rgb0 + src->linesize[0];
+        uint8_t *y0 = dst->data[0] + y * dst->linesize[0];
+        uint8_t *y1 = y0 + dst->linesize[0];
+        uint8_t *u = dst->data[1] + (y / 2) * dst->linesize[1];
+        uint8_t *v = dst->data[2] + (y / 2) * dst->linesize[2];
+
+        for (int32_t x = 0; x < src->width; x++) {
+            const uint8_t *p0 = rgb0 + 3 * x, *p1 = rgb1 + 3 * x;
+            y0[x] = (uint8_t)(16 + ((BT709_Y_R * p0[0] + BT709_Y_G * p0[1] + BT709_Y_B * p0[2] + round) >> 15));
+            y1[x] = (uint8_t)(16 + ((BT709_Y_R * p1[0] + BT709_Y_G * p1[1] + BT709_Y_B * p1[2] + round) >> 15));
+        }
+        // 色度由 2x2 块的 RGB 均值计算，与对色度取平均等价
+        for (int32_t x = 0; x < src->width / 2; x++) {
+            const uint8_t *p0 = rgb0 + 6 * x, *p1 = rgb1 + 6 * x;
+            int32_t r = p0[0] + p0[3] + p1[0] + p1[3];
+            int32_t g = p0[1] + p0[4] + p1[1] + p1[4];
+            int32_t b = p0[2] + p0[5] + p1[2] + p1[5];
+            u[x] = clip_uint8(128 + ((BT709_CB_R * r + BT709_CB_G * g + BT709_CB_B * b + (round << 2)) >> 17));
+            v[x] = clip_uint8(128 + ((BT709_CR_R * r + BT709_CR_G * g + BT709_CR_B * b + (round << 2)) >> 17));
+        }
+    }
+    return 0;
+}
+
+static int32_t yuv420p_to_rgb24(const AVFrame *src, AVFrame *dst) {
+    const int32_t round = 1 << 14;
+    for (int32_t y = 0; y < src->height; y++) {
+        const uint8_t *luma = src->data[0] + y * src->linesize[0];
+        const uint8_t *u = src->data[1] + (y / 2) * src->linesize[1];
+        const uint8_t *v = src->data[2] + (y / 2) * src->linesize[2];
+        uint8_t *rgb = dst->data[0] + y * dst->linesize[0];
+
+        for (int32_t x = 0; x < src->width; x++) {
+            int32_t c = BT709_Y_SCALE * (luma[x] - 16) + round;
+            int32_t cb = u[x / 2] - 128, cr = v[x / 2] - 128;
+            rgb[3 * x] = clip_uint8((c + BT709_R_CR * cr) >> 15);
+            rgb[3 * x + 1] = clip_uint8((c - BT709_G_CB * cb - BT709_G_CR * cr) >> 15);
+            rgb[3 * x + 2] = clip_uint8((c + BT709_B_CB * cb) >> 15);
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// 内核表与分派
+
+static const ScaleKernel scale_kernels[] = {
+    {"yuv420p_to_nv12", AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12, 1, yuv420p_to_nv12},
+    {"nv12_to_yuv420p", AV_PIX_FMT_NV12, AV_PIX_FMT_YUV420P, 1, nv12_to_yuv420p},
+    {"yuv420p_downscale_2x", AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, 2, yuv420p_downscale_2x},
+    {"yuv420p_downscale_4x", AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, 4, yuv420p_downscale_4x},
+    {"rgb24_to_yuv420p_bt709", AV_PIX_FMT_RGB24, AV_PIX_FMT_YUV420P, 1, rgb24_to_yuv420p},
+    {"yuv420p_to_rgb24_bt709", AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGB24, 1, yuv420p_to_rgb24},
+};
+
+const ScaleKernel *find_scale_kernel(
+    int32_t src_width,
+    int32_t src_height,
+    enum AVPixelFormat src_pix_fmt,
+    int32_t dst_width,
+    int32_t dst_height,
+    enum AVPixelFormat dst_pix_fmt,
+    int32_t flags) {
+    // 要求精确或可复现结果时始终交给 libswscale
+    if (flags & (SWS_ACCURATE_RND | SWS_BITEXACT)) { return nullptr; }
+    int32_t algorithm = flags & ~(SWS_FULL_CHR_H_INT | SWS_FULL_CHR_H_INP);
+
+    for (size_t i = 0; i < sizeof(scale_kernels) / sizeof(scale_kernels[0]); i++) {
+        const ScaleKernel *kernel = &scale_kernels[i];
+        if (kernel->src_pix_fmt != src_pix_fmt || kernel->dst_pix_fmt != dst_pix_fmt) { continue; }
+        if (dst_width * kernel->factor != src_width || dst_height * kernel->factor != src_height) { continue; }
+        // 4:2:0 色度平面也要整除缩小倍数
+        if (src_width % (2 * kernel->factor) || src_height % (2 * kernel->factor)) { continue; }
+        if (kernel->factor > 1 && algorithm != SWS_FAST_BILINEAR && algorithm != SWS_BILINEAR
+            && algorithm != SWS_AREA) {
+            continue;
+        }
+        return kernel;
+    }
+    return nullptr;
+}
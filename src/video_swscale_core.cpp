@@ -9,13 +9,24 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+#include "frame_pool.h"
 #include "io_data.h"
+#include "sws_context_cache.h"
+#include "video_scale_kernels.h"
 #include "video_swscale_core.h"
 
-static AVFrame *input_frame = nullptr;
+static AVFrame *input_frame = nullptr, *output_frame = nullptr;
 static struct SwsContext *sws_ctx;
 static int32_t src_width = 0, src_height = 0, dst_width = 0, dst_height = 0;
 static enum AVPixelFormat src_pix_fmt = AV_PIX_FMT_NONE, dst_pix_fmt = AV_PIX_FMT_NONE;
+static int32_t sws_threads = 1;
+static int32_t sws_flags = SWS_BILINEAR;
+static const ScaleKernel *scale_kernel = nullptr; // 匹配到专用内核时绕过 libswscale
+
+#define OUTPUT_POOL_DEPTH 4
+
+// 输出帧池，帧按默认 SIMD 对齐分配，可以直接按引用交给编码器或滤镜图
+static FramePool output_pool;
 
 static int32_t init_frame(int32_t width, int32_t height, enum AVPixelFormat pix_fmt) {
     int result = 0;
@@ -43,7 +54,65 @@ static int32_t init_frame(int32_t width, int32_t height, enum AVPixelFormat pix_
     return 0;
 }
 
-int32_t init_video_swscale(char *src_size, char *src_fmt, char *dst_size, char *dst_fmt) {
+static enum AVPixelFormat get_pix_fmt(const char *fmt) {
+    if (!strcasecmp(fmt, "YUV420P")) {
+        return AV_PIX_FMT_YUV420P;
+    } else if (!strcasecmp(fmt, "NV12")) {
+        return AV_PIX_FMT_NV12;
+    } else if (!strcasecmp(fmt, "RGB24")) {
+        return AV_PIX_FMT_RGB24;
+    }
+    return AV_PIX_FMT_NONE;
+}
+
+// 按当前的输入输出参数获取 SwsContext 并选择专用内核。
+// RGB 与 YUV 互转统一使用 BT.709 系数，保证回退到 libswscale 时与专用内核结果一致；
+// 系数作为缓存 key 的一部分传入，不修改从缓存借出的上下文
+static int32_t update_scaler() {
+    release_sws_context(sws_ctx);
+    bool rgb = src_pix_fmt == AV_PIX_FMT_RGB24 || dst_pix_fmt == AV_PIX_FMT_RGB24;
+    sws_ctx = acquire_sws_context(
+        src_width, src_height, src_pix_fmt, dst_width, dst_height, dst_pix_fmt, sws_flags, sws_threads,
+        rgb ? SWS_CS_ITU709 : SWS_CS_DEFAULT);
+    if (!sws_ctx) { return -1; }
+
+    scale_kernel =
+        find_scale_kernel(src_width, src_height, src_pix_fmt, dst_width, dst_height, dst_pix_fmt, sws_flags);
+    if (scale_kernel) { std::cout << "Use scale kernel: " << scale_kernel->name << std::endl; }
+    return 0;
+}
+
+int32_t get_sws_algorithm_flags(const char *algorithm) {
+    struct sws_algorithm_entry {
+        const char *name;
+        int32_t flags;
+    } sws_algorithm_entries[] = {
+        {"fast_bilinear", SWS_FAST_BILINEAR},
+        {"bilinear", SWS_BILINEAR},
+        {"bicubic", SWS_BICUBIC},
+        {"experimental", SWS_X},
+        {"point", SWS_POINT},
+        {"area", SWS_AREA},
+        {"bicublin", SWS_BICUBLIN},
+        {"gauss", SWS_GAUSS},
+        {"sinc", SWS_SINC},
+        {"lanczos", SWS_LANCZOS},
+        {"spline", SWS_SPLINE},
+    };
+
+    for (size_t i = 0; i < sizeof(sws_algorithm_entries) / sizeof(sws_algorithm_entries[0]); i++) {
+        if (!strcasecmp(algorithm, sws_algorithm_entries[i].name)) { return sws_algorithm_entries[i].flags; }
+    }
+    return -1;
+}
+
+int32_t init_video_swscale(
+    char *src_size,
+    char *src_fmt,
+    char *dst_size,
+    char *dst_fmt,
+    int32_t threads,
+    const char *algorithm) {
     int32_t result = 0;
 
     // 解析输入视频和输出视频的图像尺寸
@@ -58,33 +127,33 @@ int32_t init_video_swscale(char *src_size, char *src_fmt, char *dst_size, char *
     if (result < 0) {
         std::cerr << "Error: Invalid output size. Must be in the form WxH or a "
                      "valid size abbreviation.Input : "
-                  << std::string(src_size) << std::endl;
+                  << std::string(dst_size) << std::endl;
         return -1;
     }
 
     // 选择输入视频和输出视频的图像格式
-    if (!strcasecmp(src_fmt, "YUV420P")) {
-        src_pix_fmt = AV_PIX_FMT_YUV410P;
-    } else if (!strcasecmp(src_fmt, "RGB24")) {
-        src_pix_fmt = AV_PIX_FMT_RGB24;
-    } else {
+    src_pix_fmt = get_pix_fmt(src_fmt);
+    if (src_pix_fmt == AV_PIX_FMT_NONE) {
         std::cerr << "Error: Unsupported input pixel format:" << std::string(src_fmt) << std::endl;
         return -1;
     }
 
-    if (!strcasecmp(dst_fmt, "YUV420P")) {
-        dst_pix_fmt = AV_PIX_FMT_YUV410P;
-    } else if (!strcasecmp(dst_fmt, "RGB24")) {
-        dst_pix_fmt = AV_PIX_FMT_RGB24;
-    } else {
+    dst_pix_fmt = get_pix_fmt(dst_fmt);
+    if (dst_pix_fmt == AV_PIX_FMT_NONE) {
         std::cerr << "Error: Unsupported output pixel format:" << std::string(dst_fmt) << std::endl;
         return -1;
     }
 
-    // 获取SwsContext结构
-    sws_ctx = sws_getContext(
-        src_width, src_height, src_pix_fmt, dst_width, dst_height, dst_pix_fmt, SWS_BILINEAR, NULL, NULL, NULL);
-    if (!sws_ctx) {
+    // 从缓存中获取SwsContext结构，threads 为 libswscale 的切片线程数，0 表示按 CPU 核数自动选择；
+    // 多线程只在 sws_scale_frame 接口下生效，sws_scale 始终是单线程
+    sws_flags = get_sws_algorithm_flags(algorithm);
+    if (sws_flags < 0) {
+        std::cerr << "Error: Unsupported scaling algorithm:" << std::string(algorithm) << std::endl;
+        return -1;
+    }
+    sws_threads = threads;
+    result = update_scaler();
+    if (result < 0) {
         std::cerr << "Error: failed to get SwsContext." << std::endl;
         return -1;
     }
@@ -96,37 +165,99 @@ int32_t init_video_swscale(char *src_size, char *src_fmt, char *dst_size, char *
         return -1;
     }
 
+    output_frame = av_frame_alloc();
+    if (!output_frame) {
+        std::cerr << "Error: output frame allocation failed." << std::endl;
+        return -1;
+    }
+    output_frame->width = dst_width;
+    output_frame->height = dst_height;
+    output_frame->format = dst_pix_fmt;
+    result = output_pool.init(output_frame, OUTPUT_POOL_DEPTH);
+    if (result < 0) {
+        std::cerr << "Error: failed to initialize output frame pool." << std::endl;
+        return -1;
+    }
+
     return result;
 }
 
-int32_t transform(int32_t frame_cnt) {
+int32_t scale_video_frame(const AVFrame *src, AVFrame *dst) {
+    // 输入分辨率或格式在流中途变化时，换用对应几何参数的 SwsContext，输出尺寸保持不变
+    if (src->width != src_width || src->height != src_height || src->format != src_pix_fmt) {
+        src_width = src->width;
+        src_height = src->height;
+        src_pix_fmt = (enum AVPixelFormat)src->format;
+        if (update_scaler() < 0) {
+            std::cerr << "Error: failed to get SwsContext for new input geometry." << std::endl;
+            return -1;
+        }
+    }
+
     int32_t result = 0;
-    uint8_t *dst_data[4];
-    int32_t dst_linesize[4] = {0}, dst_bufsize = 0;
+    if (scale_kernel) {
+        if (!dst->buf[0]) {
+            dst->width = dst_width;
+            dst->height = dst_height;
+            dst->format = dst_pix_fmt;
+            result = av_frame_get_buffer(dst, 0);
+            if (result < 0) {
+                std::cerr << "Error: could not get output frame buffer." << std::endl;
+                return -1;
+            }
+        }
+        return scale_kernel->func(src, dst);
+    }
 
-    result = av_image_alloc(dst_data, dst_linesize, dst_width, dst_height, dst_pix_fmt, 1);
+    result = sws_scale_frame(sws_ctx, dst, src);
     if (result < 0) {
-        std::cerr << "Error: failed to alloc output frame buffer." << std::endl;
+        std::cerr << "Error: sws_scale_frame failed." << std::endl;
         return -1;
     }
-    dst_bufsize = result;
+    return 0;
+}
 
+int32_t scale_to_pooled_frame(const AVFrame *src, AVFrame *dst) {
+    int32_t result = output_pool.get_frame(dst);
+    if (result < 0) {
+        std::cerr << "Error: failed to get frame from output pool." << std::endl;
+        return -1;
+    }
+
+    result = scale_video_frame(src, dst);
+    if (result < 0) {
+        av_frame_unref(dst);
+        return result;
+    }
+    dst->pts = src->pts;
+    return 0;
+}
+
+int32_t transform(int32_t frame_cnt) {
+    int32_t result = 0;
     for (int idx = 0; idx < frame_cnt; idx++) {
         result = read_yuv_to_frame(input_frame);
         if (result < 0) {
             std::cerr << "Error: read_yuv_to_frame failed." << std::endl;
             return result;
         }
-        sws_scale(sws_ctx, input_frame->data, input_frame->linesize, 0, src_height, dst_data, dst_linesize);
+        result = scale_to_pooled_frame(input_frame, output_frame);
+        if (result < 0) { break; }
 
-        write_packed_data_to_file(dst_data[0], dst_bufsize);
+        // 逐行写出对齐的输出帧，不再经过紧凑排列的中间缓冲区
+        result = write_image_to_file(output_frame);
+        av_frame_unref(output_frame);
+        if (result < 0) { break; }
     }
 
-    av_freep(&dst_data[0]);
     return result;
 }
 
 void destroy_video_swscale() {
     av_frame_free(&input_frame);
-    sws_freeContext(sws_ctx);
+    av_frame_free(&output_frame);
+    output_pool.uninit();
+    release_sws_context(sws_ctx);
+    sws_ctx = nullptr;
+    scale_kernel = nullptr;
 }